@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+class ChunkManager;
+class MeshGenerator;
+
+using BenchClock = std::chrono::steady_clock;
+
+// results are added here so measured loops are not optimized away
+extern volatile uint64_t bench_sink;
+
+inline double
+elapsed_ms( BenchClock::time_point start )
+{
+	return std::chrono::duration<double, std::milli>( BenchClock::now() -
+	                                                   start )
+	    .count();
+}
+
+// headless world without render device, meshes stay in host memory
+struct BenchWorld
+{
+	MeshGenerator* mesh_generator;
+	ChunkManager*  chunk_manager;
+};
+
+// returns once every column in render distance of origin is generated
+void
+bench_world_open( BenchWorld& );
+
+void
+bench_world_close( BenchWorld& );
+
+void
+bench_voxel_storage();
+
+void
+bench_column_table();
+
+void
+bench_layout();
+
+void
+bench_noise();
+
+void
+bench_persistence();
+
+void
+bench_raycast();
+
+void
+bench_light();
+
+void
+bench_terrain();
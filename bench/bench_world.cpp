@@ -0,0 +1,51 @@
+#include <filesystem>
+#include <thread>
+#include "bench.hpp"
+#include "chunk_manager.hpp"
+#include "mesh_generator.hpp"
+
+// edited columns are saved here on shutdown, never into a real world
+static std::filesystem::path
+world_directory()
+{
+	return std::filesystem::temp_directory_path() / "vk_craft_bench_world";
+}
+
+void
+bench_world_open( BenchWorld& world )
+{
+	std::error_code error;
+	std::filesystem::remove_all( world_directory(), error );
+
+	world.mesh_generator = new MeshGenerator;
+	world.chunk_manager  = new ChunkManager;
+	world.mesh_generator->init( nullptr );
+	world.chunk_manager->init( world.mesh_generator,
+	                           world_directory().string() );
+
+	glm::vec3 position( 0.0f, 100.0f, 0.0f );
+	glm::vec3 direction( 1.0f, 0.0f, 0.0f );
+
+	// first frame only requests, stats are valid from second one
+	world.chunk_manager->update_visible_chunks( position, direction );
+
+	do
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+		world.chunk_manager->update_visible_chunks( position, direction );
+	} while ( world.chunk_manager->get_streaming_stats().missing_columns ||
+	          world.chunk_manager->get_generation_stats().in_flight );
+}
+
+void
+bench_world_close( BenchWorld& world )
+{
+	world.chunk_manager->shutdown();
+	world.mesh_generator->shutdown();
+	delete world.chunk_manager;
+	delete world.mesh_generator;
+	world = {};
+
+	std::error_code error;
+	std::filesystem::remove_all( world_directory(), error );
+}
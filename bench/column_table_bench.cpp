@@ -0,0 +1,222 @@
+#define GLM_ENABLE_EXPERIMENTAL
+#include <cmath>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <glm/gtx/hash.hpp>
+#include "bench.hpp"
+#include "column_table.hpp"
+#include "constants.hpp"
+
+static constexpr int32_t FRAMES = 4000;
+// voxel reads of meshing, edits and raycasts near player per frame
+static constexpr int32_t FINDS_PER_FRAME = 512;
+
+struct Access
+{
+	enum Op : uint8_t
+	{
+		INSERT,
+		FIND,
+		ERASE,
+		OP_COUNT
+	};
+
+	Op         op;
+	glm::ivec2 key;
+};
+
+static const char* OP_NAMES[] = { "insert", "find", "erase" };
+
+// player flies over the world and turns slowly. columns entering view are
+// inserted and their neighbors looked up, columns past unload distance are
+// erased a few per frame like eviction does
+static void
+record_session( std::vector<Access>& session )
+{
+	std::mt19937                   random( 3 );
+	std::set<std::pair<int, int>>  resident;
+	std::vector<glm::ivec2>        entered;
+	glm::vec2                      position( 0.0f );
+	const int32_t                  view = CHUNKS_IN_RENDER_DISTANCE;
+
+	for ( int32_t frame = 0; frame < FRAMES; frame++ )
+	{
+		float heading = float( frame ) * 0.002f;
+		position +=
+		    0.3f * glm::vec2( std::cos( heading ), std::sin( heading ) );
+		glm::ivec2 center( glm::floor( position ) );
+
+		for ( int32_t z = center.y - view; z < center.y + view; z++ )
+		{
+			for ( int32_t x = center.x - view; x < center.x + view; x++ )
+			{
+				if ( !resident.insert( { x, z } ).second )
+				{
+					continue;
+				}
+
+				session.push_back( { Access::INSERT, { x, z } } );
+				entered.push_back( { x, z } );
+			}
+		}
+
+		for ( const glm::ivec2& column : entered )
+		{
+			for ( int32_t dz = -1; dz <= 1; dz++ )
+			{
+				for ( int32_t dx = -1; dx <= 1; dx++ )
+				{
+					if ( dx != 0 || dz != 0 )
+					{
+						session.push_back(
+						    { Access::FIND, column + glm::ivec2( dx, dz ) } );
+					}
+				}
+			}
+		}
+
+		entered.clear();
+
+		// mostly hits around player, some misses past view edge
+		for ( int32_t i = 0; i < FINDS_PER_FRAME; i++ )
+		{
+			int32_t    spread = i % 10 == 0 ? view + 4 : 4;
+			glm::ivec2 offset( int32_t( random() % ( 2 * spread + 1 ) ),
+			                   int32_t( random() % ( 2 * spread + 1 ) ) );
+			session.push_back(
+			    { Access::FIND, center + offset - glm::ivec2( spread ) } );
+		}
+
+		int32_t erased = 0;
+
+		for ( auto it = resident.begin();
+		      it != resident.end() && erased < COLUMN_EVICTIONS_PER_FRAME; )
+		{
+			int32_t distance = std::max( std::abs( it->first - center.x ),
+			                             std::abs( it->second - center.y ) );
+
+			if ( distance <= CHUNKS_UNLOAD_DISTANCE )
+			{
+				++it;
+				continue;
+			}
+
+			session.push_back(
+			    { Access::ERASE, { it->first, it->second } } );
+			it = resident.erase( it );
+			erased++;
+		}
+	}
+}
+
+// what chunk manager used before column table
+struct UnorderedMapTable
+{
+	std::unordered_map<glm::ivec2, ChunkColumn*> map;
+
+	ChunkColumn*
+	find( const glm::ivec2& key ) const
+	{
+		auto it = map.find( key );
+		return it != map.end() ? it->second : nullptr;
+	}
+
+	void
+	insert( const glm::ivec2& key, ChunkColumn* column )
+	{
+		map.emplace( key, column );
+	}
+
+	ChunkColumn*
+	erase( const glm::ivec2& key )
+	{
+		ChunkColumn* column = find( key );
+		map.erase( key );
+		return column;
+	}
+};
+
+// ops are timed in runs of equal op, runs are long enough for the clock
+template <typename Table>
+static void
+replay( const char* name, const std::vector<Access>& session )
+{
+	Table    table;
+	double   op_ms[ Access::OP_COUNT ]    = {};
+	size_t   op_count[ Access::OP_COUNT ] = {};
+	uint64_t sum                          = 0;
+
+	BenchClock::time_point session_start = BenchClock::now();
+
+	for ( size_t begin = 0; begin < session.size(); )
+	{
+		Access::Op op  = session[ begin ].op;
+		size_t     end = begin;
+
+		while ( end < session.size() && session[ end ].op == op )
+		{
+			end++;
+		}
+
+		BenchClock::time_point start = BenchClock::now();
+
+		for ( size_t i = begin; i < end; i++ )
+		{
+			const glm::ivec2& key = session[ i ].key;
+
+			switch ( op )
+			{
+			case Access::INSERT:
+				// table never dereferences columns
+				table.insert( key, ( ChunkColumn* ) uintptr_t( i + 1 ) );
+				break;
+			case Access::FIND: sum += uintptr_t( table.find( key ) ); break;
+			default: sum += uintptr_t( table.erase( key ) ); break;
+			}
+		}
+
+		op_ms[ op ] += elapsed_ms( start );
+		op_count[ op ] += end - begin;
+		begin = end;
+	}
+
+	double session_ms = elapsed_ms( session_start );
+	bench_sink += sum;
+
+	std::printf( "%-14s", name );
+
+	for ( int32_t op = 0; op < Access::OP_COUNT; op++ )
+	{
+		std::printf( " %s %5.1f ns",
+		             OP_NAMES[ op ],
+		             op_ms[ op ] * 1e6 / double( op_count[ op ] ) );
+	}
+
+	std::printf( "  session %.1f ms\n", session_ms );
+}
+
+void
+bench_column_table()
+{
+	std::vector<Access> session;
+	record_session( session );
+
+	size_t counts[ Access::OP_COUNT ] = {};
+
+	for ( const Access& access : session )
+	{
+		counts[ access.op ]++;
+	}
+
+	std::printf( "%d frames, %zu inserts, %zu finds, %zu erases\n",
+	             FRAMES,
+	             counts[ Access::INSERT ],
+	             counts[ Access::FIND ],
+	             counts[ Access::ERASE ] );
+
+	replay<ColumnTable>( "column_table", session );
+	replay<UnorderedMapTable>( "unordered_map", session );
+}
@@ -0,0 +1,170 @@
+#include <memory>
+#include <random>
+#include <vector>
+#include "bench.hpp"
+#include "chunk_manager.hpp"
+#include "mesh_generator.hpp"
+#include "raycast.hpp"
+
+// columns generated per fill pass, all sections kept at once
+static constexpr int32_t FILL_COLUMNS = 16;
+static constexpr int32_t FILL_PASSES  = 8;
+static constexpr int32_t RAY_COUNT    = 20000;
+static constexpr float   RAY_RANGE    = 100.0f;
+
+static const char*
+layout_name()
+{
+#if defined( VK_CRAFT_USE_PDEP )
+	return "morton pdep";
+#elif defined( VK_CRAFT_MORTON_LAYOUT )
+	return "morton table";
+#else
+	return "linear";
+#endif
+}
+
+// Chunk::init of every section, heightmaps are generated up front
+static void
+run_fill()
+{
+	std::vector<Heightmap> heightmaps( FILL_COLUMNS * FILL_PASSES );
+
+	for ( int32_t column = 0; column < FILL_COLUMNS * FILL_PASSES; column++ )
+	{
+		glm::ivec2 position( column % 16, column / 16 );
+		generate_heightmap( heightmaps[ column ], position );
+	}
+
+	std::vector<Chunk> chunks( FILL_COLUMNS * WORLD_HEIGHT_IN_CHUNKS );
+	double             fill_ms = 0.0;
+
+	for ( int32_t pass = 0; pass < FILL_PASSES; pass++ )
+	{
+		BenchClock::time_point start = BenchClock::now();
+
+		for ( int32_t column = 0; column < FILL_COLUMNS; column++ )
+		{
+			int32_t          idx     = pass * FILL_COLUMNS + column;
+			const Heightmap& heights = heightmaps[ idx ];
+
+			for ( int32_t y = 0; y < WORLD_HEIGHT_IN_CHUNKS; y++ )
+			{
+				chunks[ column * WORLD_HEIGHT_IN_CHUNKS + y ].init(
+				    { idx % 16, y, idx / 16 }, nullptr, nullptr, heights );
+			}
+		}
+
+		fill_ms += elapsed_ms( start );
+
+		for ( Chunk& chunk : chunks )
+		{
+			bench_sink += chunk.voxel_count;
+			chunk.clear();
+		}
+	}
+
+	double sections = double( FILL_COLUMNS ) * FILL_PASSES *
+	                  WORLD_HEIGHT_IN_CHUNKS;
+
+	std::printf( "fill     %8.0f sections/s  %7.1f Mvoxel/s\n",
+	             sections * 1000.0 / fill_ms,
+	             sections * CHUNK_SIZE_CUBED / fill_ms / 1000.0 );
+}
+
+// snapshot and greedy mesh of every non empty chunk in render distance
+static void
+run_meshing( const ChunkManager& manager )
+{
+	auto     snapshot = std::make_unique<ChunkSnapshot>();
+	Vertices vertices;
+	Indices  indices;
+	size_t   meshed      = 0;
+	double   snapshot_ms = 0.0;
+	double   mesh_ms     = 0.0;
+
+	for ( int32_t x = -CHUNKS_IN_RENDER_DISTANCE;
+	      x <= CHUNKS_IN_RENDER_DISTANCE;
+	      x++ )
+	{
+		for ( int32_t z = -CHUNKS_IN_RENDER_DISTANCE;
+		      z <= CHUNKS_IN_RENDER_DISTANCE;
+		      z++ )
+		{
+			for ( int32_t y = 0; y < WORLD_HEIGHT_IN_CHUNKS; y++ )
+			{
+				const Chunk* chunk = manager.find_chunk( { x, y, z } );
+
+				if ( chunk == nullptr || chunk->voxel_count == 0 )
+				{
+					continue;
+				}
+
+				BenchClock::time_point start = BenchClock::now();
+				manager.build_snapshot( *chunk, *snapshot );
+				snapshot_ms += elapsed_ms( start );
+
+				start = BenchClock::now();
+				vertices.clear();
+				indices.clear();
+				mesh_snapshot( *snapshot, vertices, indices, nullptr, false );
+				mesh_ms += elapsed_ms( start );
+
+				bench_sink += indices.size();
+				meshed++;
+			}
+		}
+	}
+
+	std::printf( "snapshot %8.0f chunks/s\n", meshed * 1000.0 / snapshot_ms );
+	std::printf( "mesh     %8.0f chunks/s\n", meshed * 1000.0 / mesh_ms );
+}
+
+// rays from above terrain in random directions, most hit ground
+static void
+run_raycast( const ChunkManager& manager )
+{
+	std::mt19937                          random( 1 );
+	std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+	std::vector<Ray>                      rays( RAY_COUNT );
+
+	for ( Ray& ray : rays )
+	{
+		ray.origin    = { unit( random ) * RENDER_DISTANCE * 0.7f,
+		                  80.0f + unit( random ) * 40.0f,
+		                  unit( random ) * RENDER_DISTANCE * 0.7f };
+		ray.direction = { unit( random ), unit( random ), unit( random ) };
+		ray.range     = RAY_RANGE;
+	}
+
+	size_t                 hits  = 0;
+	BenchClock::time_point start = BenchClock::now();
+
+	for ( const Ray& ray : rays )
+	{
+		hits += raycast( manager, ray.origin, ray.direction, ray.range )
+		            .has_value();
+	}
+
+	double ray_ms = elapsed_ms( start );
+	bench_sink += hits;
+
+	std::printf( "raycast  %8.2f Mrays/s  %zu of %d hit\n",
+	             RAY_COUNT / ray_ms / 1000.0,
+	             hits,
+	             RAY_COUNT );
+}
+
+void
+bench_layout()
+{
+	std::printf( "layout %s\n", layout_name() );
+
+	run_fill();
+
+	BenchWorld world;
+	bench_world_open( world );
+	run_meshing( *world.chunk_manager );
+	run_raycast( *world.chunk_manager );
+	bench_world_close( world );
+}
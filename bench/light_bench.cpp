@@ -0,0 +1,120 @@
+#include <random>
+#include <vector>
+#include "bench.hpp"
+#include "chunk_manager.hpp"
+
+// edits of every kind, each one undone before next
+static constexpr int32_t EDIT_COUNT = 64;
+
+// box relative to first AIR voxel above surface
+struct LightEdit
+{
+	const char* name;
+	glm::ivec3  min;
+	glm::ivec3  max;
+	Voxel::Type voxel;
+};
+
+static const LightEdit LIGHT_EDITS[] = {
+    // block light added, then removed
+    { "lamp", { 0, 0, 0 }, { 0, 0, 0 }, Voxel::LAMP },
+    // sky light falls into a one voxel hole
+    { "dig", { 0, -1, 0 }, { 0, -1, 0 }, Voxel::AIR },
+    { "shaft", { 0, -24, 0 }, { 0, -1, 0 }, Voxel::AIR },
+    // sky light removed under a slab
+    { "roof", { -4, 6, -4 }, { 3, 6, 3 }, Voxel::STONE },
+};
+
+static glm::ivec3
+surface( const ChunkManager& manager, int32_t x, int32_t z )
+{
+	int32_t y = WORLD_HEIGHT - 1;
+
+	while ( y > 0 && manager.get_voxel( { x, y - 1, z } ) == Voxel::AIR )
+	{
+		y--;
+	}
+
+	return { x, y, z };
+}
+
+// time of edit call including relight, and light voxels it rewrote
+template <typename F>
+static double
+timed_edit( ChunkManager& manager, size_t& relit, F edit )
+{
+	size_t                 before = manager.get_light_stats().relit_voxels;
+	BenchClock::time_point start  = BenchClock::now();
+	edit();
+	double ms = elapsed_ms( start );
+	relit += manager.get_light_stats().relit_voxels - before;
+	return ms;
+}
+
+static void
+run_edit( ChunkManager& manager, const LightEdit& light_edit )
+{
+	std::mt19937                           random( 11 );
+	std::uniform_int_distribution<int32_t> coordinate( -RENDER_DISTANCE / 2,
+	                                                   RENDER_DISTANCE / 2 );
+	std::vector<Voxel::Type>               saved;
+	double                                 apply_ms    = 0.0;
+	double                                 undo_ms     = 0.0;
+	size_t                                 apply_relit = 0;
+	size_t                                 undo_relit  = 0;
+
+	for ( int32_t i = 0; i < EDIT_COUNT; i++ )
+	{
+		glm::ivec3 origin =
+		    surface( manager, coordinate( random ), coordinate( random ) );
+		glm::ivec3 min  = origin + light_edit.min;
+		glm::ivec3 max  = origin + light_edit.max;
+		glm::ivec3 size = max - min + 1;
+
+		// same order copy_buffer writes back
+		saved.clear();
+
+		for ( int32_t y = 0; y < size.y; y++ )
+		{
+			for ( int32_t z = 0; z < size.z; z++ )
+			{
+				for ( int32_t x = 0; x < size.x; x++ )
+				{
+					glm::ivec3 position = min + glm::ivec3( x, y, z );
+					saved.push_back( manager.get_voxel( position ) );
+				}
+			}
+		}
+
+		apply_ms += timed_edit(
+		    manager,
+		    apply_relit,
+		    [ & ] { manager.fill_box( min, max, light_edit.voxel ); } );
+		undo_ms += timed_edit(
+		    manager,
+		    undo_relit,
+		    [ & ] { manager.copy_buffer( min, size, saved.data() ); } );
+	}
+
+	std::printf( "%-6s apply %7.1f us %6zu voxels  undo %7.1f us %6zu "
+	             "voxels\n",
+	             light_edit.name,
+	             apply_ms * 1000.0 / EDIT_COUNT,
+	             apply_relit / EDIT_COUNT,
+	             undo_ms * 1000.0 / EDIT_COUNT,
+	             undo_relit / EDIT_COUNT );
+}
+
+void
+bench_light()
+{
+	BenchWorld world;
+	bench_world_open( world );
+
+	for ( const LightEdit& light_edit : LIGHT_EDITS )
+	{
+		run_edit( *world.chunk_manager, light_edit );
+	}
+
+	bench_world_close( world );
+}
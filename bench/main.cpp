@@ -0,0 +1,41 @@
+#include <cstring>
+#include "bench.hpp"
+#include "voxel.hpp"
+
+volatile uint64_t bench_sink = 0;
+
+struct Benchmark
+{
+	const char* name;
+	void ( *run )();
+};
+
+static const Benchmark BENCHMARKS[] = {
+    { "voxel_storage", bench_voxel_storage },
+    { "column_table", bench_column_table },
+    { "layout", bench_layout },
+    { "light", bench_light },
+    { "noise", bench_noise },
+    { "persistence", bench_persistence },
+    { "raycast", bench_raycast },
+    { "terrain", bench_terrain },
+};
+
+int
+main( int argc, char** argv )
+{
+	init_voxel_data_storage();
+
+	for ( const Benchmark& benchmark : BENCHMARKS )
+	{
+		if ( argc > 1 && std::strcmp( argv[ 1 ], benchmark.name ) != 0 )
+		{
+			continue;
+		}
+
+		std::printf( "== %s\n", benchmark.name );
+		benchmark.run();
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <glm/gtc/noise.hpp>
+#include "bench.hpp"
+#include "constants.hpp"
+#include "noise.hpp"
+
+// 16x16 planes of samples per noise pass
+static constexpr int32_t PLANE_COUNT = 4096;
+
+// kernel against scalar glm on same samples, one plane of a chunk per call
+static void
+run_noise()
+{
+	std::vector<float> x( CHUNK_SIZE_SQUARED );
+	std::vector<float> y( CHUNK_SIZE_SQUARED );
+	std::vector<float> z( CHUNK_SIZE_SQUARED );
+	std::vector<float> out( CHUNK_SIZE_SQUARED );
+	double             batch_ms  = 0.0;
+	double             scalar_ms = 0.0;
+	float              max_diff  = 0.0f;
+
+	for ( int32_t plane = 0; plane < PLANE_COUNT; plane++ )
+	{
+		for ( int32_t idx = 0; idx < CHUNK_SIZE_SQUARED; idx++ )
+		{
+			x[ idx ] = ( plane * CHUNK_SIZE + idx % CHUNK_SIZE ) / 32.0f;
+			y[ idx ] = plane / 7.0f;
+			z[ idx ] = ( plane / 64 * CHUNK_SIZE + idx / CHUNK_SIZE ) / 32.0f;
+		}
+
+		BenchClock::time_point start = BenchClock::now();
+		noise_batch( x.data(), y.data(), z.data(), out.data(), x.size() );
+		batch_ms += elapsed_ms( start );
+
+		start = BenchClock::now();
+
+		for ( int32_t idx = 0; idx < CHUNK_SIZE_SQUARED; idx++ )
+		{
+			glm::vec3 sample( x[ idx ], y[ idx ], z[ idx ] );
+			float     diff = std::abs( glm::perlin( sample ) - out[ idx ] );
+			max_diff       = std::max( max_diff, diff );
+		}
+
+		scalar_ms += elapsed_ms( start );
+	}
+
+	double samples = double( PLANE_COUNT ) * CHUNK_SIZE_SQUARED / 1000.0;
+
+	std::printf( "noise    %u lanes %7.1f Msamples/s  scalar %7.1f "
+	             "Msamples/s  max diff %g\n",
+	             noise_lane_count(),
+	             samples / batch_ms,
+	             samples / scalar_ms,
+	             max_diff );
+}
+
+void
+bench_noise()
+{
+	run_noise();
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+#include "bench.hpp"
+#include "chunk_column.hpp"
+#include "chunk_pool.hpp"
+#include "heightmap_cache.hpp"
+#include "structures.hpp"
+#include "world_storage.hpp"
+
+// columns generated, saved and loaded back, 16 x 16 fits one region
+static constexpr int32_t COLUMN_SIDE  = 16;
+static constexpr int32_t COLUMN_COUNT = COLUMN_SIDE * COLUMN_SIDE;
+
+// same work as generation workers do for a column without saved data
+static void
+generate_column( ChunkColumn&    column,
+                 ChunkPool&      chunk_pool,
+                 HeightmapCache& heightmap_cache )
+{
+	Heightmap heights;
+	heightmap_cache.get( column.position, heights );
+
+	int32_t max_height =
+	    *std::max_element( heights.heights.begin(), heights.heights.end() );
+
+	for ( int32_t y = 0; y * CHUNK_SIZE < max_height; y++ )
+	{
+		Chunk* chunk = chunk_pool.acquire();
+		chunk->init( glm::ivec3( column.position.x, y, column.position.y ),
+		             nullptr,
+		             &column,
+		             heights );
+		column.sections[ y ] = chunk;
+	}
+
+	place_structures( column, heights, nullptr, chunk_pool, heightmap_cache );
+}
+
+static void
+release_column( ChunkColumn& column, ChunkPool& chunk_pool )
+{
+	for ( Chunk*& chunk : column.sections )
+	{
+		if ( chunk != nullptr )
+		{
+			chunk_pool.release( chunk );
+			chunk = nullptr;
+		}
+	}
+}
+
+// per column latency of generating it against reading back its saved
+// snapshot, files are written to a scratch directory removed afterwards
+void
+bench_persistence()
+{
+	std::filesystem::path directory =
+	    std::filesystem::temp_directory_path() / "vk_craft_bench_regions";
+	std::error_code error;
+	std::filesystem::remove_all( directory, error );
+
+	ChunkPool      chunk_pool;
+	HeightmapCache heightmap_cache;
+	WorldStorage   world_storage;
+	chunk_pool.init( CHUNK_POOL_RESERVE, ChunkPool::ReleaseMode::IMMEDIATE );
+	heightmap_cache.init( HEIGHTMAP_CACHE_CAPACITY );
+	world_storage.init( directory.string(),
+	                    WorldStorage::Mode::SNAPSHOT,
+	                    nullptr,
+	                    &chunk_pool );
+
+	std::vector<ChunkColumn> columns( COLUMN_COUNT );
+	double                   generate_ms = 0.0;
+	double                   save_ms     = 0.0;
+	double                   load_ms     = 0.0;
+	size_t                   loaded      = 0;
+
+	for ( int32_t i = 0; i < COLUMN_COUNT; i++ )
+	{
+		ChunkColumn& column = columns[ i ];
+		column.position     = { i % COLUMN_SIDE, i / COLUMN_SIDE };
+		column.sections.fill( nullptr );
+
+		BenchClock::time_point start = BenchClock::now();
+		generate_column( column, chunk_pool, heightmap_cache );
+		generate_ms += elapsed_ms( start );
+
+		start = BenchClock::now();
+		world_storage.save_column( column );
+		save_ms += elapsed_ms( start );
+
+		release_column( column, chunk_pool );
+	}
+
+	for ( ChunkColumn& column : columns )
+	{
+		BenchClock::time_point start = BenchClock::now();
+		loaded += world_storage.load_column( column );
+		load_ms += elapsed_ms( start );
+
+		release_column( column, chunk_pool );
+	}
+
+	WorldStorageStats stats = world_storage.get_stats();
+
+	std::printf( "generate %7.1f us/column\n",
+	             generate_ms * 1000.0 / COLUMN_COUNT );
+	std::printf( "save     %7.1f us/column  %zu bytes/column\n",
+	             save_ms * 1000.0 / COLUMN_COUNT,
+	             stats.bytes_written / COLUMN_COUNT );
+	std::printf( "load     %7.1f us/column  %zu of %d loaded\n",
+	             load_ms * 1000.0 / COLUMN_COUNT,
+	             loaded,
+	             COLUMN_COUNT );
+
+	world_storage.shutdown();
+	heightmap_cache.shutdown();
+	chunk_pool.shutdown();
+	std::filesystem::remove_all( directory, error );
+}
@@ -0,0 +1,92 @@
+#include <random>
+#include <vector>
+#include "bench.hpp"
+#include "chunk_manager.hpp"
+#include "raycast.hpp"
+
+// rays cast per measurement, whatever the batch size
+static constexpr int32_t RAYS_PER_RUN = 65536;
+
+// short rays of entities and sensors, long ones of line of sight checks
+static constexpr float RAY_RANGES[] = { 16.0f, 64.0f, 256.0f };
+
+static std::vector<Ray>
+make_rays( float range )
+{
+	std::mt19937                          random( 3 );
+	std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+	std::vector<Ray>                      rays( RAYS_PER_RUN );
+
+	for ( Ray& ray : rays )
+	{
+		ray.origin    = { unit( random ) * RENDER_DISTANCE * 0.5f,
+		                  90.0f + unit( random ) * 30.0f,
+		                  unit( random ) * RENDER_DISTANCE * 0.5f };
+		ray.direction = { unit( random ), unit( random ), unit( random ) };
+		ray.range     = range;
+	}
+
+	return rays;
+}
+
+// one raycast call after another against raycast_batch of batch_size rays
+static void
+run_range( const ChunkManager& manager, float range )
+{
+	std::vector<Ray>                          rays = make_rays( range );
+	std::vector<Ray>                          batch;
+	std::vector<std::optional<RaycastResult>> results;
+	size_t                                    hits  = 0;
+	BenchClock::time_point                    start = BenchClock::now();
+
+	for ( const Ray& ray : rays )
+	{
+		hits += raycast( manager, ray.origin, ray.direction, ray.range )
+		            .has_value();
+	}
+
+	double serial_ms = elapsed_ms( start );
+
+	std::printf( "range %3.0f  single      %5.2f Mrays/s  %5.1f%% hit\n",
+	             range,
+	             RAYS_PER_RUN / serial_ms / 1000.0,
+	             100.0 * hits / RAYS_PER_RUN );
+
+	for ( size_t batch_size : { 64, 512, 4096, RAYS_PER_RUN } )
+	{
+		start = BenchClock::now();
+
+		for ( size_t begin = 0; begin < rays.size(); begin += batch_size )
+		{
+			batch.assign( rays.begin() + begin,
+			              rays.begin() + begin + batch_size );
+			raycast_batch( manager, batch, results );
+			bench_sink += results.back().has_value();
+		}
+
+		double batch_ms = elapsed_ms( start );
+
+		std::printf( "range %3.0f  batch %-5zu %5.2f Mrays/s  %7.1f us/batch\n",
+		             range,
+		             batch_size,
+		             RAYS_PER_RUN / batch_ms / 1000.0,
+		             batch_ms * 1000.0 * batch_size / RAYS_PER_RUN );
+	}
+}
+
+void
+bench_raycast()
+{
+	BenchWorld world;
+	bench_world_open( world );
+
+	const WorkerPool& workers = world.chunk_manager->get_raycast_workers();
+	std::printf( "%u raycast workers\n", workers.get_worker_count() );
+
+	for ( float range : RAY_RANGES )
+	{
+		run_range( *world.chunk_manager, range );
+	}
+
+	bench_world_close( world );
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <vector>
+#include "bench.hpp"
+#include "chunk.hpp"
+#include "terrain.hpp"
+
+// columns per generation pass, sections per cave pass span heights caves
+// reach
+static constexpr int32_t COLUMN_COUNT       = 512;
+static constexpr int32_t CAVE_COLUMNS       = 64;
+static constexpr int32_t CAVE_SECTION_COUNT = 5;
+
+// heightmap and sections up to top of a column as generation workers do,
+// single thread so rates are per core
+static void
+run_generation()
+{
+	std::vector<Chunk> chunks( WORLD_HEIGHT_IN_CHUNKS );
+	double             heightmap_ms = 0.0;
+	double             fill_ms      = 0.0;
+	size_t             sections     = 0;
+
+	for ( int32_t column = 0; column < COLUMN_COUNT; column++ )
+	{
+		glm::ivec2 position( column % 32, column / 32 );
+		Heightmap  heights;
+
+		BenchClock::time_point start = BenchClock::now();
+		generate_heightmap( heights, position );
+		heightmap_ms += elapsed_ms( start );
+
+		int32_t top =
+		    *std::max_element( heights.heights.begin(), heights.heights.end() );
+
+		start = BenchClock::now();
+
+		for ( int32_t y = 0; y * CHUNK_SIZE < top; y++ )
+		{
+			chunks[ y ].init(
+			    { position.x, y, position.y }, nullptr, nullptr, heights );
+			sections++;
+		}
+
+		fill_ms += elapsed_ms( start );
+
+		for ( Chunk& chunk : chunks )
+		{
+			bench_sink += chunk.voxel_count;
+			chunk.clear();
+		}
+	}
+
+	std::printf( "heightmap %7.2f us/column\n",
+	             heightmap_ms * 1000.0 / COLUMN_COUNT );
+	std::printf( "fill      %7.2f us/section  %.1f sections/column\n",
+	             fill_ms * 1000.0 / sections,
+	             double( sections ) / COLUMN_COUNT );
+	std::printf( "generate  %7.0f chunks/s per core\n",
+	             sections * 1000.0 / ( heightmap_ms + fill_ms ) );
+}
+
+static size_t
+count_bits( uint32_t bits )
+{
+	size_t count = 0;
+
+	for ( ; bits != 0; bits &= bits - 1 )
+	{
+		count++;
+	}
+
+	return count;
+}
+
+// interpolated caves against noise at every voxel, differing voxels are
+// counted against voxels exact caves carve
+static void
+run_caves()
+{
+	CaveMask interpolated;
+	CaveMask exact;
+	double   interpolated_ms = 0.0;
+	double   exact_ms        = 0.0;
+	size_t   carved          = 0;
+	size_t   differing       = 0;
+
+	for ( int32_t column = 0; column < CAVE_COLUMNS; column++ )
+	{
+		for ( int32_t y = 0; y < CAVE_SECTION_COUNT; y++ )
+		{
+			glm::ivec3 position( column % 8, y, column / 8 );
+
+			BenchClock::time_point start = BenchClock::now();
+			sample_caves( interpolated, position );
+			interpolated_ms += elapsed_ms( start );
+
+			start = BenchClock::now();
+			sample_caves_exact( exact, position );
+			exact_ms += elapsed_ms( start );
+
+			for ( int32_t i = 0; i < CHUNK_SIZE_SQUARED; i++ )
+			{
+				carved += count_bits( exact.columns[ i ] );
+				differing += count_bits( interpolated.columns[ i ] ^
+				                         exact.columns[ i ] );
+			}
+		}
+	}
+
+	double sections = double( CAVE_COLUMNS ) * CAVE_SECTION_COUNT;
+
+	std::printf( "caves     %7.2f us/section interpolated  %7.1f us/section "
+	             "exact\n",
+	             interpolated_ms * 1000.0 / sections,
+	             exact_ms * 1000.0 / sections );
+	std::printf( "caves     %zu voxels carved, differing %.2f%% of carved "
+	             "%.3f%% of all\n",
+	             carved,
+	             100.0 * differing / std::max<size_t>( carved, 1 ),
+	             100.0 * differing / ( sections * CHUNK_SIZE_CUBED ) );
+}
+
+void
+bench_terrain()
+{
+	init_terrain( WORLD_SEED );
+	run_generation();
+	run_caves();
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "bench.hpp"
+#include "voxel_storage.hpp"
+
+static constexpr int32_t CHUNK_COUNT = 512;
+
+enum class Pattern
+{
+	UNIFORM,
+	// stone, ground and grass layers under air, most common section
+	SURFACE,
+	// every type scattered, widest palette
+	MIXED
+};
+
+static const char* PATTERN_NAMES[] = { "uniform", "surface", "mixed" };
+
+static Voxel::Type
+pattern_voxel( Pattern pattern, int32_t idx, std::mt19937& random )
+{
+	int32_t y = idx / CHUNK_SIZE_SQUARED;
+
+	switch ( pattern )
+	{
+	case Pattern::UNIFORM: return Voxel::STONE;
+	case Pattern::SURFACE:
+		return y < 6    ? Voxel::STONE
+		       : y < 9  ? Voxel::GROUND
+		       : y < 10 ? Voxel::GRASS
+		                : Voxel::AIR;
+	default: return Voxel::Type( random() % Voxel::COUNT );
+	}
+}
+
+template <typename Storage>
+static void
+run_storage( const char* storage_name, Pattern pattern )
+{
+	std::mt19937             random( 7 );
+	std::vector<Voxel::Type> source( CHUNK_SIZE_CUBED );
+
+	for ( int32_t idx = 0; idx < CHUNK_SIZE_CUBED; idx++ )
+	{
+		source[ idx ] = pattern_voxel( pattern, idx, random );
+	}
+
+	std::vector<uint32_t> shuffled( CHUNK_SIZE_CUBED );
+
+	for ( int32_t idx = 0; idx < CHUNK_SIZE_CUBED; idx++ )
+	{
+		shuffled[ idx ] = idx;
+	}
+
+	std::shuffle( shuffled.begin(), shuffled.end(), random );
+
+	std::vector<Storage> chunks( CHUNK_COUNT );
+
+	// palette grows while chunk is written the first time, second pass
+	// only rewrites known types
+	BenchClock::time_point start = BenchClock::now();
+
+	for ( Storage& chunk : chunks )
+	{
+		for ( int32_t idx = 0; idx < CHUNK_SIZE_CUBED; idx++ )
+		{
+			chunk.set( idx, source[ idx ] );
+		}
+	}
+
+	double first_set_ms = elapsed_ms( start );
+	start               = BenchClock::now();
+
+	for ( Storage& chunk : chunks )
+	{
+		for ( uint32_t idx : shuffled )
+		{
+			chunk.set( idx, source[ idx ] );
+		}
+	}
+
+	double set_ms = elapsed_ms( start );
+	start         = BenchClock::now();
+	uint64_t sum  = 0;
+
+	for ( const Storage& chunk : chunks )
+	{
+		for ( int32_t idx = 0; idx < CHUNK_SIZE_CUBED; idx++ )
+		{
+			sum += chunk.get( idx );
+		}
+	}
+
+	double get_ms = elapsed_ms( start );
+	start         = BenchClock::now();
+
+	for ( const Storage& chunk : chunks )
+	{
+		for ( uint32_t idx : shuffled )
+		{
+			sum += chunk.get( idx );
+		}
+	}
+
+	double random_get_ms = elapsed_ms( start );
+	bench_sink += sum;
+
+	double voxels = double( CHUNK_COUNT ) * CHUNK_SIZE_CUBED / 1000.0;
+
+	std::printf( "%-8s %-8s fill %7.1f  set %7.1f  get %7.1f  random get "
+	             "%7.1f Mvoxel/s  %5zu bytes/chunk\n",
+	             storage_name,
+	             PATTERN_NAMES[ int( pattern ) ],
+	             voxels / first_set_ms,
+	             voxels / set_ms,
+	             voxels / get_ms,
+	             voxels / random_get_ms,
+	             sizeof( Storage ) + chunks[ 0 ].heap_usage() );
+}
+
+void
+bench_voxel_storage()
+{
+	for ( Pattern pattern :
+	      { Pattern::UNIFORM, Pattern::SURFACE, Pattern::MIXED } )
+	{
+		run_storage<FlatVoxelStorage>( "flat", pattern );
+		run_storage<PaletteVoxelStorage>( "palette", pattern );
+	}
+}
@@ -6,6 +6,67 @@ workspace "vk_craft"
 		default     = "build"
 	}
 
+	newoption {
+		trigger     = "voxel_storage",
+		value       = "TYPE",
+		description = "chunk voxel storage",
+		allowed     = {
+			{ "palette", "palette indices, 0-8 bits per voxel" },
+			{ "flat",    "plain array, 16 bits per voxel" }
+		},
+		default     = "palette"
+	}
+
+	newoption {
+		trigger     = "voxel_layout",
+		value       = "LAYOUT",
+		description = "order of voxels inside chunk storage",
+		allowed     = {
+			{ "linear", "x + 256 * y + 16 * z" },
+			{ "morton", "z-order, uses pdep with simd=avx2" }
+		},
+		default     = "linear"
+	}
+
+	newoption {
+		trigger     = "simd",
+		value       = "ISA",
+		description = "vector instructions used by terrain noise",
+		allowed     = {
+			{ "none", "scalar noise" },
+			{ "sse4", "4 samples per instruction" },
+			{ "avx2", "8 samples per instruction" }
+		},
+		default     = "sse4"
+	}
+
+	-- embedded spir-v of shaders/, run after editing a shader and commit the
+	-- regenerated sources. needs glslangValidator and xxd on path
+	newaction {
+		trigger     = "shaders",
+		description = "compile shaders/*.hlsl into src/shader_*.cpp",
+		execute     = function()
+			for _, name in ipairs({ "main", "ui" }) do
+				for _, stage in ipairs({ "vert", "frag" }) do
+					local source = "shaders/" .. name .. "." .. stage .. ".hlsl"
+					local shader = "shader_" .. name .. "_" .. stage
+					-- xxd names the array after the file
+					local spirv   = shader .. "_spirv"
+					local compile = "glslangValidator -D -V -e main -S " ..
+						stage .. " -o src/" .. spirv .. " " .. source
+					local embed   = "cd src && xxd -i " .. spirv .. " > " ..
+						shader .. ".cpp"
+					local ok      = os.execute( compile ) and
+						os.execute( embed )
+					os.remove( "src/" .. spirv )
+					if not ok then
+						error( "failed to compile " .. source )
+					end
+				end
+			end
+		end
+	}
+
 	build_directory = path.getabsolute(_OPTIONS["build_directory"]);
     location(path.getabsolute(_OPTIONS["build_directory"]))
     targetdir (build_directory .. '/%{cfg.longname}')
@@ -20,14 +81,57 @@ workspace "vk_craft"
 
     include("deps/fluent/fluent-engine.lua")
 
-    project "vk_craft"
-        kind "WindowedApp"
-
+	-- options, includes and libraries shared by game and benchmarks
+	function vk_craft_settings()
 		filter "configurations:debug"
 			symbols "On"
 			defines { "FLUENT_DEBUG" }
 		filter { }
 
+		filter "options:voxel_storage=palette"
+			defines { "VK_CRAFT_PALETTE_STORAGE" }
+		filter { }
+
+		filter "options:voxel_layout=morton"
+			defines { "VK_CRAFT_MORTON_LAYOUT" }
+		filter { }
+
+		filter "options:simd=sse4"
+			vectorextensions "SSE4.1"
+		filter "options:simd=avx2"
+			vectorextensions "AVX2"
+		-- pdep of morton layout, every avx2 cpu has it
+		filter { "options:simd=avx2", "toolset:gcc or clang" }
+			buildoptions { "-mbmi2" }
+		filter { }
+
+		sysincludedirs
+		{
+			"deps/fluent/sources",
+			"deps/fluent/sources/third_party/",
+			"deps/glm",
+		}
+
+		links
+		{
+			"ft_renderer",
+			"ft_os",
+			"ft_log"
+		}
+
+		fluent_engine.link()
+
+		-- column generation workers
+		filter "system:linux"
+			links { "pthread" }
+		filter {}
+	end
+
+    project "vk_craft"
+        kind "WindowedApp"
+
+		vk_craft_settings()
+
         files
         {
             "src/main.cpp",
@@ -36,8 +140,24 @@ workspace "vk_craft"
             "src/chunk.hpp",
             "src/chunk_manager.cpp",
             "src/chunk_manager.hpp",
+            "src/chunk_pool.cpp",
+            "src/chunk_pool.hpp",
+            "src/chunk_column.hpp",
+            "src/chunk_snapshot.hpp",
+            "src/column_table.cpp",
+            "src/column_table.hpp",
+            "src/column_edits.hpp",
+            "src/column_generator.cpp",
+            "src/column_generator.hpp",
+            "src/heightmap_cache.cpp",
+            "src/heightmap_cache.hpp",
 			"src/constantrs.hpp",
 			"src/coordinates.hpp",
+			"src/light_engine.cpp",
+			"src/light_engine.hpp",
+			"src/lod_terrain.cpp",
+			"src/lod_terrain.hpp",
+			"src/lru_list.hpp",
 			"src/main_pass.cpp",
             "src/main_pass.hpp",
 			"src/mesh.hpp",
@@ -45,11 +165,26 @@ workspace "vk_craft"
 			"src/mesh_generator.hpp",
 			"src/mesh_renderer.cpp",
 			"src/mesh_renderer.hpp",
+			"src/noise.cpp",
+			"src/noise.hpp",
 			"src/quad.hpp",
+			"src/raycast.cpp",
 			"src/raycast.hpp",
+			"src/region_file.cpp",
+			"src/region_file.hpp",
+			"src/structures.cpp",
+			"src/structures.hpp",
+			"src/terrain.cpp",
+			"src/terrain.hpp",
 			"src/vertex.hpp",
 			"src/voxel.cpp",
 			"src/voxel.hpp",
+			"src/voxel_storage.cpp",
+			"src/voxel_storage.hpp",
+			"src/world_storage.cpp",
+			"src/world_storage.hpp",
+			"src/worker_pool.cpp",
+			"src/worker_pool.hpp",
 			"src/ui_renderer.cpp",
 			"src/ui_renderer.hpp",
             "src/shader_main_vert.cpp",
@@ -80,18 +215,44 @@ workspace "vk_craft"
 			buildoutputs { "%{cfg.targetdir}/%{file.name}" }
 		filter {}
 
-        sysincludedirs 
-        {
-            "deps/fluent/sources",
-            "deps/fluent/sources/third_party/",
-            "deps/glm",
-        }
-        
-        links 
-        { 
-            "ft_renderer", 
-            "ft_os", 
-            "ft_log"
-        }
-    
-        fluent_engine.link()
+	-- world code without window. run release build, a name on command
+	-- line runs only that benchmark
+	project "vk_craft_bench"
+		kind "ConsoleApp"
+
+		vk_craft_settings()
+
+		includedirs { "src" }
+
+		files
+		{
+			"bench/bench.hpp",
+			"bench/bench_world.cpp",
+			"bench/column_table_bench.cpp",
+			"bench/layout_bench.cpp",
+			"bench/light_bench.cpp",
+			"bench/main.cpp",
+			"bench/noise_bench.cpp",
+			"bench/persistence_bench.cpp",
+			"bench/raycast_bench.cpp",
+			"bench/terrain_bench.cpp",
+			"bench/voxel_storage_bench.cpp",
+			"src/chunk.cpp",
+			"src/chunk_manager.cpp",
+			"src/chunk_pool.cpp",
+			"src/column_generator.cpp",
+			"src/column_table.cpp",
+			"src/heightmap_cache.cpp",
+			"src/light_engine.cpp",
+			"src/lod_terrain.cpp",
+			"src/mesh_generator.cpp",
+			"src/noise.cpp",
+			"src/raycast.cpp",
+			"src/region_file.cpp",
+			"src/structures.cpp",
+			"src/terrain.cpp",
+			"src/voxel.cpp",
+			"src/voxel_storage.cpp",
+			"src/world_storage.cpp",
+			"src/worker_pool.cpp"
+		}
@@ -14,6 +14,8 @@ struct Input
 {
     centroid float2 texcoord : TEXCOORD0;
     float face : TEXCOORD1;
+    float light : TEXCOORD2;
+    float ao : TEXCOORD3;
 };
 
 struct Output
@@ -32,7 +34,15 @@ Output main(Input input)
 
     float ndotl = max(dot(normals[uint(input.face)], float3(0.0, 1.0, 0.0)), 0.5);
 
+    // sky light in high nibble, block light in low one, every level
+    // below full is a fifth darker
+    float sky = floor(input.light / 16.0);
+    float block = input.light - sky * 16.0;
+    float brightness = pow(0.8, 15.0 - max(sky, block));
+    // fully occluded corner is half as bright
+    brightness *= lerp(0.5, 1.0, input.ao / 3.0);
+
     Output output;
-    output.color = float4(ndotl * tex_color.rgb, 1.0);
+    output.color = float4(ndotl * brightness * tex_color.rgb, 1.0);
     return output;
 }
@@ -9,12 +9,16 @@ struct Input
     float3 position : POSITION;
     float2 texcoord : TEXCOORD0;
     float face : TEXCOORD1;
+    float light : TEXCOORD2;
+    float ao : TEXCOORD3;
 };
 
 struct Output
 {
     float2 texcoord : TEXCOORD0;
     float face : TEXCOORD1;
+    float light : TEXCOORD2;
+    float ao : TEXCOORD3;
     float4 position : SV_Position;
 };
 
@@ -24,5 +28,7 @@ Output main(Input input)
     output.position = mul(projection, mul(view, float4(input.position, 1.0f)));
     output.texcoord = input.texcoord;
     output.face = input.face;
+    output.light = input.light;
+    output.ao = input.ao;
     return output;
 }
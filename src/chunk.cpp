@@ -1,57 +1,114 @@
 #include <algorithm>
-#include <glm/gtc/noise.hpp>
 #include "coordinates.hpp"
 #include "chunk_manager.hpp"
+#include "chunk_column.hpp"
 #include "chunk.hpp"
 
-static inline Voxel::Type
-height_to_voxel( int32_t height, int32_t top )
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+// index of lowest set bit, bits is not 0
+static inline int32_t
+lowest_bit( uint32_t bits )
 {
-	if ( height < 2 )
-	{
-		return Voxel::WATER;
-	}
-	else if ( height < 5 )
-	{
-		return Voxel::SAND;
-	}
-	else if ( height < 7 )
+#if defined( _MSC_VER )
+	unsigned long index;
+	_BitScanForward( &index, bits );
+	return int32_t( index );
+#else
+	return __builtin_ctz( bits );
+#endif
+}
+
+Chunk::Chunk()
+{
+	// data is already filled with AIR by storage
+	clear_occupancy();
+	clear_light();
+}
+
+void
+Chunk::clear()
+{
+	data.fill( Voxel::AIR );
+	clear_occupancy();
+	clear_light();
+}
+
+void
+Chunk::clear_occupancy()
+{
+	for ( auto& rows : x_rows )
 	{
-		return Voxel::STONE;
+		rows.fill( 0 );
 	}
-	else if ( height < top - 1 )
+	for ( auto& rows : z_rows )
 	{
-		return Voxel::GROUND;
+		rows.fill( 0 );
 	}
+	voxel_count = 0;
+	brick_voxels.fill( 0 );
+	brick_mask = 0;
+}
 
-	return Voxel::GRASS;
+void
+Chunk::clear_light()
+{
+	light_used    = false;
+	shaded_voxels = 0;
 }
 
 void
-Chunk::init( const glm::vec3 pos, ChunkManager* manager, size_t last_access_frame )
+Chunk::attach( const glm::ivec3 pos,
+               ChunkManager*    manager,
+               ChunkColumn*     owner )
 {
-	chunk_manager           = manager;
-	this->last_access_frame = last_access_frame;
+	chunk_manager = manager;
+	column        = owner;
+	position      = pos;
+	// cached mesh may belong to previous chunk at this position
+	modified = true;
+}
 
-	position[ 0 ] = pos[ 0 ];
-	position[ 1 ] = pos[ 1 ];
-	position[ 2 ] = pos[ 2 ];
+void
+Chunk::init( const glm::ivec3 pos,
+             ChunkManager*    manager,
+             ChunkColumn*     owner,
+             const Heightmap& heights )
+{
+	attach( pos, manager, owner );
+
+	// chunk comes from pool already filled with AIR
+	int32_t bottom = position.y * CHUNK_SIZE;
+
+	CaveMask caves;
+	sample_caves( caves, position );
 
 	for ( int32_t x = 0; x < CHUNK_SIZE; x++ )
 	{
 		for ( int32_t z = 0; z < CHUNK_SIZE; z++ )
 		{
-			float noise = ( perlin( glm::vec2( x + pos.x * CHUNK_SIZE,
-			                                   z + pos.z * CHUNK_SIZE ) /
-			                        float( CHUNK_SIZE * 2 ) ) +
-			                1.0f ) /
-			              2.0f;
-			int32_t height =
-			    std::clamp( int32_t( noise * CHUNK_SIZE ), 2, CHUNK_SIZE );
-			for ( int32_t y = 0; y < height; y++ )
+			int32_t     height = heights.heights[ x + CHUNK_SIZE * z ];
+			Biome::Type biome  = heights.biomes[ x + CHUNK_SIZE * z ];
+			int32_t     top    = std::clamp( height - bottom, 0, CHUNK_SIZE );
+			// voxels below top minus cave voxels, filled one run at a time
+			uint32_t solid =
+			    ( ( 1u << top ) - 1u ) & ~caves.columns[ x + CHUNK_SIZE * z ];
+
+			while ( solid != 0 )
 			{
-				auto idx    = x + CHUNK_SIZE * CHUNK_SIZE * y + CHUNK_SIZE * z;
-				data[ idx ] = height_to_voxel( y, height );
+				int32_t y   = lowest_bit( solid );
+				int32_t end = y + lowest_bit( ~( solid >> y ) );
+				solid &= ~0u << end;
+
+				for ( ; y < end; y++ )
+				{
+					Voxel::Type voxel =
+					    column_voxel( bottom + y, height, biome );
+					data.set( local_voxel_to_index( { x, y, z } ), voxel );
+					update_occupancy( { x, y, z }, Voxel::AIR, voxel );
+				}
 			}
 		}
 	}
@@ -75,134 +132,80 @@ Chunk::safe_get_voxel( const glm::ivec3 block_position ) const
 Voxel::Type
 Chunk::get_voxel( const glm::ivec3 block_position ) const
 {
-	size_t idx = block_position[ 0 ] +
-	             CHUNK_SIZE * CHUNK_SIZE * block_position[ 1 ] +
-	             CHUNK_SIZE * block_position[ 2 ];
-
-	return data[ idx ];
+	return data.get( local_voxel_to_index( block_position ) );
 }
 
 void
 Chunk::set_voxel( const glm::ivec3 block_position, Voxel::Type voxel )
 {
-	size_t idx = block_position[ 0 ] +
-	             CHUNK_SIZE * CHUNK_SIZE * block_position[ 1 ] +
-	             CHUNK_SIZE * block_position[ 2 ];
+	uint32_t    idx       = local_voxel_to_index( block_position );
+	Voxel::Type old_voxel = data.get( idx );
 
-	data[ idx ] = voxel;
-	modified    = true;
+	data.set( idx, voxel );
+	update_occupancy( block_position, old_voxel, voxel );
+	modified = true;
 }
 
-std::array<Voxel::Type, Face::COUNT>
-Chunk::get_neighbors( const glm::ivec3 block_position ) const
+void
+Chunk::set_light( const glm::ivec3 block_position, Light value )
 {
-	std::array<Voxel::Type, Face::COUNT> result;
-	result.fill( Voxel::AIR );
-
-	for ( uint32_t i = 0; i < Face::COUNT; i++ )
+	if ( !light_used )
 	{
-		switch ( i )
-		{
-		case Face::FRONT:
+		if ( value == OPEN_SKY_LIGHT )
 		{
-			if ( block_position.z == CHUNK_SIZE - 1 )
-			{
-				glm::ivec3 pos;
-				local_voxel_to_global( pos, position, block_position );
-				pos += glm::ivec3( 0, 0, 1 );
-
-				result[ i ] = chunk_manager->get_voxel( pos );
-			}
-			else
-			{
-				result[ i ] =
-				    get_voxel( block_position + glm::ivec3( 0, 0, 1 ) );
-			}
-			break;
+			return;
 		}
-		case Face::BACK:
-		{
-			if ( block_position.z == 0 )
-			{
-				glm::ivec3 pos;
-				local_voxel_to_global( pos, position, block_position );
-				pos += glm::ivec3( 0, 0, -1 );
-				result[ i ] = chunk_manager->get_voxel( pos );
-			}
-			else
-			{
-				result[ i ] =
-				    get_voxel( block_position + glm::ivec3( 0, 0, -1 ) );
-			}
-			break;
-		}
-		case Face::LEFT:
+
+		if ( light == nullptr )
 		{
-			if ( block_position.x == 0 )
-			{
-				glm::ivec3 pos;
-				local_voxel_to_global( pos, position, block_position );
-				pos += glm::ivec3( -1, 0, 0 );
-				result[ i ] = chunk_manager->get_voxel( pos );
-			}
-			else
-			{
-				result[ i ] =
-				    get_voxel( block_position + glm::ivec3( -1, 0, 0 ) );
-			}
-			break;
+			light = std::make_unique<LightArray>();
 		}
-		case Face::RIGHT:
-		{
-			if ( block_position.x == CHUNK_SIZE - 1 )
-			{
-				glm::ivec3 pos;
-				local_voxel_to_global( pos, position, block_position );
-				pos += glm::ivec3( 1, 0, 0 );
-				result[ i ] = chunk_manager->get_voxel( pos );
-			}
-			else
-			{
-				result[ i ] =
-				    get_voxel( block_position + glm::ivec3( 1, 0, 0 ) );
-			}
-			break;
-		}
-		case Face::BOTTOM:
+
+		light->fill( OPEN_SKY_LIGHT );
+		light_used = true;
+	}
+
+	Light& old_value = ( *light )[ local_voxel_to_index( block_position ) ];
+
+	shaded_voxels += value != OPEN_SKY_LIGHT;
+	shaded_voxels -= old_value != OPEN_SKY_LIGHT;
+	old_value = value;
+}
+
+void
+Chunk::update_occupancy( const glm::ivec3 block_position,
+                         Voxel::Type      old_voxel,
+                         Voxel::Type      voxel )
+{
+	uint16_t x_bit = uint16_t( 1u << block_position.x );
+	uint16_t z_bit = uint16_t( 1u << block_position.z );
+	uint32_t x_row = block_position.y + CHUNK_SIZE * block_position.z;
+	uint32_t z_row = block_position.x + CHUNK_SIZE * block_position.y;
+	uint32_t brick = brick_index( block_position );
+
+	if ( old_voxel != Voxel::AIR )
+	{
+		Occupancy plane = is_transparent( old_voxel ) ? TRANSPARENT : SOLID;
+		x_rows[ plane ][ x_row ] &= ~x_bit;
+		z_rows[ plane ][ z_row ] &= ~z_bit;
+		voxel_count--;
+
+		if ( --brick_voxels[ brick ] == 0 )
 		{
-			if ( block_position.y == 0 )
-			{
-				glm::ivec3 pos;
-				local_voxel_to_global( pos, position, block_position );
-				pos += glm::ivec3( 0, -1, 0 );
-				result[ i ] = chunk_manager->get_voxel( pos );
-			}
-			else
-			{
-				result[ i ] =
-				    get_voxel( block_position + glm::ivec3( 0, -1, 0 ) );
-			}
-			break;
+			brick_mask &= ~( uint64_t( 1 ) << brick );
 		}
-		case Face::TOP:
+	}
+
+	if ( voxel != Voxel::AIR )
+	{
+		Occupancy plane = is_transparent( voxel ) ? TRANSPARENT : SOLID;
+		x_rows[ plane ][ x_row ] |= x_bit;
+		z_rows[ plane ][ z_row ] |= z_bit;
+		voxel_count++;
+
+		if ( brick_voxels[ brick ]++ == 0 )
 		{
-			if ( block_position.y == CHUNK_SIZE - 1 )
-			{
-				glm::ivec3 pos;
-				local_voxel_to_global( pos, position, block_position );
-				pos += glm::ivec3( 0, 1, 0 );
-				result[ i ] = chunk_manager->get_voxel( pos );
-			}
-			else
-			{
-				result[ i ] =
-				    get_voxel( block_position + glm::ivec3( 0, 1, 0 ) );
-			}
-			break;
-		}
-		default: break;
+			brick_mask |= uint64_t( 1 ) << brick;
 		}
 	}
-
-	return result;
 }
@@ -2,23 +2,75 @@
 
 #include <cstdint>
 #include <array>
+#include <memory>
 #include <fluent/os.h>
 #include "constants.hpp"
+#include "coordinates.hpp"
 #include "quad.hpp"
+#include "terrain.hpp"
 #include "voxel.hpp"
+#include "voxel_storage.hpp"
 
 struct ChunkManager;
+struct ChunkColumn;
 
 struct Chunk
 {
-	ChunkManager*                         chunk_manager;
-	glm::ivec3                            position;
-	std::array<Voxel::Type, CHUNK_SIZE_CUBED> data;
-	mutable bool                          modified = false;
-	mutable size_t                        last_access_frame;
+	enum Occupancy : uint32_t
+	{
+		SOLID,
+		TRANSPARENT,
+		OCCUPANCY_COUNT
+	};
 
+	using OccupancyRows = std::array<uint16_t, CHUNK_SIZE_SQUARED>;
+	using LightArray    = std::array<Light, CHUNK_SIZE_CUBED>;
+
+	// coarse occupancy, chunk is split into 4x4x4 voxel bricks
+	static constexpr int32_t BRICK_SIZE  = 4;
+	static constexpr int32_t BRICK_COUNT =
+	    CHUNK_SIZE_CUBED / ( BRICK_SIZE * BRICK_SIZE * BRICK_SIZE );
+	static_assert( BRICK_COUNT <= 64, "brick mask must fit 64 bits" );
+
+	ChunkManager* chunk_manager;
+	ChunkColumn*  column;
+	glm::ivec3    position;
+	VoxelStorage  data;
+	mutable bool  modified = false;
+
+	// bit x of x_rows[ plane ][ y + CHUNK_SIZE * z ]
+	std::array<OccupancyRows, OCCUPANCY_COUNT> x_rows;
+	// bit z of z_rows[ plane ][ x + CHUNK_SIZE * y ]
+	std::array<OccupancyRows, OCCUPANCY_COUNT> z_rows;
+	// non AIR voxels
+	uint32_t voxel_count;
+	// non AIR voxels of every brick, bit of brick_mask is set while its
+	// brick has any
+	std::array<uint8_t, BRICK_COUNT> brick_voxels;
+	uint64_t                         brick_mask;
+	// same layout as data, used once any voxel holds something else than
+	// OPEN_SKY_LIGHT. opaque voxels are kept at OPEN_SKY_LIGHT. array stays
+	// allocated when chunk is recycled
+	std::unique_ptr<LightArray> light;
+	bool                        light_used;
+	// voxels whose light is not OPEN_SKY_LIGHT
+	uint32_t shaded_voxels;
+
+	Chunk();
+
+	// back to all AIR
+	void
+	clear();
+
+	// places pooled AIR chunk into column without generating anything
 	void
-	init( const glm::vec3 position, ChunkManager*, size_t );
+	attach( const glm::ivec3 position, ChunkManager*, ChunkColumn* );
+
+	void
+	init( const glm::ivec3 position,
+	      ChunkManager*,
+	      ChunkColumn*,
+	      const Heightmap& heights );
 
 	Voxel::Type
 	safe_get_voxel( const glm::ivec3 block_position ) const;
@@ -28,6 +80,97 @@ struct Chunk
 	void
 	set_voxel( const glm::ivec3 block_position, Voxel::Type voxel );
 
-	std::array<Voxel::Type, Face::COUNT>
-	get_neighbors( const glm::ivec3 block_position ) const;
+	bool
+	is_empty() const
+	{
+		return voxel_count == 0;
+	}
+
+	// all AIR under open sky, column may leave such section unallocated
+	bool
+	is_elidable() const
+	{
+		return voxel_count == 0 && shaded_voxels == 0;
+	}
+
+	Light
+	get_light( const glm::ivec3 block_position ) const
+	{
+		return light_used
+		           ? ( *light )[ local_voxel_to_index( block_position ) ]
+		           : OPEN_SKY_LIGHT;
+	}
+
+	void
+	set_light( const glm::ivec3 block_position, Light value );
+
+	uint16_t
+	get_x_row( Occupancy plane, int32_t y, int32_t z ) const
+	{
+		return x_rows[ plane ][ y + CHUNK_SIZE * z ];
+	}
+
+	uint16_t
+	get_z_row( Occupancy plane, int32_t x, int32_t y ) const
+	{
+		return z_rows[ plane ][ x + CHUNK_SIZE * y ];
+	}
+
+	// solid or transparent voxels along x
+	uint16_t
+	get_occupied_x_row( int32_t y, int32_t z ) const
+	{
+		return get_x_row( SOLID, y, z ) | get_x_row( TRANSPARENT, y, z );
+	}
+
+	// solid or transparent voxels along z
+	uint16_t
+	get_occupied_z_row( int32_t x, int32_t y ) const
+	{
+		return get_z_row( SOLID, x, y ) | get_z_row( TRANSPARENT, x, y );
+	}
+
+	static uint32_t
+	brick_index( const glm::ivec3 block_position )
+	{
+		return ( block_position.x / BRICK_SIZE ) +
+		       ( CHUNK_SIZE / BRICK_SIZE ) *
+		           ( ( block_position.y / BRICK_SIZE ) +
+		             ( CHUNK_SIZE / BRICK_SIZE ) *
+		                 ( block_position.z / BRICK_SIZE ) );
+	}
+
+	// true when whole brick around voxel is AIR
+	bool
+	is_brick_empty( const glm::ivec3 block_position ) const
+	{
+		return ( ( brick_mask >> brick_index( block_position ) ) & 1 ) == 0;
+	}
+
+	bool
+	is_air( const glm::ivec3 block_position ) const
+	{
+		return ( ( get_occupied_x_row( block_position.y, block_position.z ) >>
+		           block_position.x ) &
+		         1 ) == 0;
+	}
+
+	size_t
+	memory_usage() const
+	{
+		return sizeof( Chunk ) + data.heap_usage() +
+		       ( light_used ? sizeof( LightArray ) : 0 );
+	}
+
+private:
+	void
+	clear_occupancy();
+
+	void
+	clear_light();
+
+	void
+	update_occupancy( const glm::ivec3 block_position,
+	                  Voxel::Type      old_voxel,
+	                  Voxel::Type      voxel );
 };
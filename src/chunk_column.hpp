@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include "constants.hpp"
+#include "chunk.hpp"
+#include "column_edits.hpp"
+
+// vertical stack of chunk sections, sections which contain only AIR are
+// not allocated and stay nullptr
+struct ChunkColumn
+{
+	enum State : uint8_t
+	{
+		// sections are being generated by worker, do not touch them
+		PENDING,
+		GENERATED
+	};
+
+	// ( x, z ) in chunks
+	glm::ivec2                                 position;
+	State                                      state;
+	std::array<Chunk*, WORLD_HEIGHT_IN_CHUNKS> sections;
+	size_t                                     last_access_frame;
+	// residency order of chunk manager, columns in view are not in it
+	ChunkColumn* lru_prev;
+	ChunkColumn* lru_next;
+	bool         in_view;
+	// voxel data of sections, counted against VOXEL_MEMORY_BUDGET
+	size_t memory_bytes;
+	// changed by player since generated or loaded, saved on unload
+	bool edited;
+	// sections were restored from a saved snapshot, edits alone can not
+	// rebuild this column
+	bool        snapshot;
+	ColumnEdits edits;
+
+	Chunk*
+	get_section( int32_t y ) const
+	{
+		if ( y < 0 || y >= WORLD_HEIGHT_IN_CHUNKS )
+		{
+			return nullptr;
+		}
+
+		return sections[ y ];
+	}
+
+	// x and z are local to column, y is world height
+	Voxel::Type
+	get_voxel( const glm::ivec3 position ) const
+	{
+		if ( position.y < 0 || position.y >= WORLD_HEIGHT )
+		{
+			return Voxel::AIR;
+		}
+
+		const Chunk* section = sections[ position.y / CHUNK_SIZE ];
+
+		if ( section == nullptr )
+		{
+			return Voxel::AIR;
+		}
+
+		return section->get_voxel(
+		    { position.x, position.y % CHUNK_SIZE, position.z } );
+	}
+};
@@ -1,57 +1,624 @@
+#include <algorithm>
+#include <tuple>
 #include "coordinates.hpp"
 #include "mesh_generator.hpp"
 #include "chunk_manager.hpp"
 
 void
-ChunkManager::init( MeshGenerator* mesh_generator )
+ChunkManager::init( MeshGenerator*     mesh_generator,
+                    const std::string& world_directory )
 {
-	this->mesh_generator     = mesh_generator;
-	last_update_position     = glm::ivec3( 0, 0, 0 );
-	world_changed_last_frame = false;
-	frame_count              = 0;
+	this->mesh_generator = mesh_generator;
+	frame_count          = 0;
+	voxel_bytes          = 0;
+	view_center          = glm::ivec2( 0, 0 );
+	view_valid           = false;
+	visible_changed      = false;
+	load_order           = LoadOrder::VIEW;
+	streaming_stats      = {};
+	remesh_stats         = {};
+	filling_view         = false;
+	front_filled         = false;
+	view_columns.fill( nullptr );
+	// workers and far terrain generate from it
+	init_terrain( WORLD_SEED );
+	chunk_pool.init( CHUNK_POOL_RESERVE, ChunkPool::ReleaseMode::DEFERRED );
+	heightmap_cache.init( HEIGHTMAP_CACHE_CAPACITY );
+	world_storage.init(
+	    world_directory, WorldStorage::Mode::OVERLAY, this, &chunk_pool );
+	column_generator.init(
+	    this, &chunk_pool, &heightmap_cache, &world_storage );
+	light_engine.init( this, &chunk_pool, &columns );
+	lod_terrain.init();
+	// calling thread casts its share too
+	raycast_workers.init(
+	    std::max( std::thread::hardware_concurrency(), 1u ) - 1 );
 }
 
-bool
-ChunkManager::need_update_chunks( const glm::ivec3& chunk_position ) const
+void
+ChunkManager::shutdown()
+{
+	// workers must be done with columns before they are freed. whole world
+	// goes away, so neighbors, meshes and residency are left as they are
+	column_generator.shutdown();
+	columns.erase_if(
+	    [ & ]( ChunkColumn* column )
+	    {
+		    release_column( column );
+		    return true;
+	    } );
+	resident_columns.clear();
+	view_columns.fill( nullptr );
+	view_valid = false;
+	visible_chunks.clear();
+	dirty_chunks.clear();
+	load_requests.clear();
+	chunk_pool.shutdown();
+	heightmap_cache.shutdown();
+	world_storage.shutdown();
+	lod_terrain.shutdown();
+	raycast_workers.shutdown();
+}
+
+void
+ChunkManager::request_column( const glm::ivec2& position )
+{
+	ChunkColumn* column       = new ChunkColumn;
+	column->position          = position;
+	column->state             = ChunkColumn::PENDING;
+	column->last_access_frame = frame_count;
+	column->edited            = false;
+	column->snapshot          = false;
+	column->memory_bytes      = 0;
+	column->in_view           = true;
+	column->sections.fill( nullptr );
+
+	columns.insert( position, column );
+	view_slot( position ) = column;
+	column_generator.request( column );
+}
+
+void
+ChunkManager::mark_dirty( const glm::ivec3& chunk_position )
+{
+	dirty_chunks.push_back( chunk_position );
+	remesh_stats.invalidations++;
+}
+
+void
+ChunkManager::flush_dirty_chunks()
+{
+	if ( dirty_chunks.empty() )
+	{
+		return;
+	}
+
+	auto less = []( const glm::ivec3& a, const glm::ivec3& b )
+	{ return std::tie( a.x, a.y, a.z ) < std::tie( b.x, b.y, b.z ); };
+
+	std::sort( dirty_chunks.begin(), dirty_chunks.end(), less );
+	auto last = std::unique( dirty_chunks.begin(), dirty_chunks.end() );
+	remesh_stats.remeshes_avoided += dirty_chunks.end() - last;
+	dirty_chunks.erase( last, dirty_chunks.end() );
+
+	for ( const glm::ivec3& chunk_position : dirty_chunks )
+	{
+		// chunk may have been emptied or unloaded since it was marked
+		Chunk* chunk = find_chunk( chunk_position );
+
+		if ( chunk == nullptr )
+		{
+			continue;
+		}
+
+		chunk->modified = true;
+
+		if ( chunk->column->in_view )
+		{
+			mesh_generator->remesh_chunk( *chunk );
+			remesh_stats.remeshes++;
+		}
+	}
+
+	dirty_chunks.clear();
+}
+
+ChunkColumn*
+ChunkManager::find_generated_column( const glm::ivec2& position ) const
+{
+	ChunkColumn* column = columns.find( position );
+
+	if ( column == nullptr || column->state == ChunkColumn::PENDING )
+	{
+		return nullptr;
+	}
+
+	return column;
+}
+
+void
+ChunkManager::touch_column( ChunkColumn* column ) const
+{
+	column->last_access_frame = frame_count;
+
+	if ( !column->in_view )
+	{
+		resident_columns.touch( column );
+	}
+}
+
+void
+ChunkManager::unload_column( ChunkColumn* column )
+{
+	invalidate_neighbors( column->position );
+	voxel_bytes -= column->memory_bytes;
+
+	if ( !column->in_view )
+	{
+		resident_columns.remove( column );
+	}
+
+	for ( Chunk* chunk : column->sections )
+	{
+		if ( chunk != nullptr )
+		{
+			mesh_generator->drop_chunk( chunk->position );
+		}
+	}
+
+	release_column( column );
+}
+
+void
+ChunkManager::release_column( ChunkColumn* column )
 {
-	glm::ivec3 v = last_update_position - chunk_position;
+	// never generated columns have nothing worth saving
+	if ( column->edited && column->state == ChunkColumn::GENERATED )
+	{
+		world_storage.save_column( *column );
+	}
+
+	for ( Chunk* chunk : column->sections )
+	{
+		if ( chunk != nullptr )
+		{
+			chunk_pool.release( chunk );
+		}
+	}
 
-	return ( v.x * v.x + v.z * v.z <
-	         CHUNKS_IN_RENDER_DISTANCE * CHUNKS_IN_RENDER_DISTANCE ) ||
-	       world_changed_last_frame;
+	delete column;
+}
+
+void
+ChunkManager::release_section( Chunk* chunk )
+{
+	chunk->column->sections[ chunk->position.y ] = nullptr;
+	visible_changed                              = true;
+	mesh_generator->drop_chunk( chunk->position );
+	chunk_pool.release( chunk );
 }
 
 void
-ChunkManager::update_visible_chunks( const glm::vec3& position )
+ChunkManager::relight()
 {
-	if ( ( frame_count % 10 ) == 0 )
+	light_engine.propagate();
+
+	LightEngine::Changes& changes = light_engine.get_changes();
+	voxel_bytes += changes.bytes;
+	visible_changed |= changes.sections_added;
+
+	for ( const glm::ivec3& chunk_position : changes.chunks )
 	{
-		bool erase_something = false;
-		for ( auto it = chunks.begin(); it != chunks.end(); )
+		Chunk* chunk = find_chunk( chunk_position );
+
+		if ( chunk == nullptr )
+		{
+			continue;
+		}
+
+		// dug out section may be lit by open sky again only now
+		if ( chunk->is_elidable() )
 		{
-			if ( frame_count - it->second.last_access_frame > 10 )
+			size_t bytes = chunk->memory_usage();
+			chunk->column->memory_bytes -= bytes;
+			voxel_bytes -= bytes;
+			release_section( chunk );
+			continue;
+		}
+
+		mark_dirty( chunk_position );
+	}
+
+	changes.chunks.clear();
+	changes.bytes          = 0;
+	changes.sections_added = false;
+}
+
+Chunk*
+ChunkManager::find_chunk( const glm::ivec3& chunk_position ) const
+{
+	const ChunkColumn* column = find_generated_column(
+	    glm::ivec2( chunk_position.x, chunk_position.z ) );
+
+	if ( column == nullptr )
+	{
+		return nullptr;
+	}
+
+	return column->get_section( chunk_position.y );
+}
+
+void
+ChunkManager::invalidate_neighbors( const glm::ivec2& position )
+{
+	// diagonal columns read the corner apron for ambient occlusion
+	static const glm::ivec2 offsets[ 8 ] = {
+	    { -1, 0 },
+	    { 1, 0 },
+	    { 0, -1 },
+	    { 0, 1 },
+	    { -1, -1 },
+	    { 1, -1 },
+	    { -1, 1 },
+	    { 1, 1 },
+	};
+
+	for ( const glm::ivec2& offset : offsets )
+	{
+		ChunkColumn* neighbor = find_generated_column( position + offset );
+
+		if ( neighbor == nullptr )
+		{
+			continue;
+		}
+
+		for ( const Chunk* chunk : neighbor->sections )
+		{
+			if ( chunk != nullptr )
+			{
+				mark_dirty( chunk->position );
+			}
+		}
+	}
+}
+
+void
+ChunkManager::build_snapshot( const Chunk&   chunk,
+                              ChunkSnapshot& snapshot ) const
+{
+	snapshot.position = chunk.position;
+	snapshot.empty    = chunk.is_empty();
+	snapshot.scale    = 1;
+	snapshot.voxels.fill( Voxel::AIR );
+	snapshot.light.fill( OPEN_SKY_LIGHT );
+	snapshot.slices.fill( 0 );
+
+	for ( int32_t b = 0; b < CHUNK_SIZE; b++ )
+	{
+		for ( int32_t a = 0; a < CHUNK_SIZE; a++ )
+		{
+			snapshot.x_rows[ a + CHUNK_SIZE * b ] =
+			    chunk.get_occupied_x_row( a, b );
+			snapshot.z_rows[ a + CHUNK_SIZE * b ] =
+			    chunk.get_occupied_z_row( a, b );
+		}
+	}
+
+	for ( int32_t z = 0; z < CHUNK_SIZE; z++ )
+	{
+		for ( int32_t y = 0; y < CHUNK_SIZE; y++ )
+		{
+			uint16_t row = snapshot.x_rows[ y + CHUNK_SIZE * z ];
+
+			// empty rows are already AIR
+			if ( row == 0 )
+			{
+				continue;
+			}
+
+			snapshot.slices[ 0 ] |= row;
+			snapshot.slices[ 1 ] |= 1u << y;
+			snapshot.slices[ 2 ] |= 1u << z;
+
+			for ( int32_t x = 0; x < CHUNK_SIZE; x++ )
 			{
-				it              = chunks.erase( it );
-				erase_something = true;
+				snapshot.voxels[ ChunkSnapshot::index( x, y, z ) ] =
+				    chunk.get_voxel( { x, y, z } );
 			}
-			else
+		}
+	}
+
+	// light matters in AIR too, so whole chunk is copied
+	if ( chunk.light_used )
+	{
+		for ( int32_t z = 0; z < CHUNK_SIZE; z++ )
+		{
+			for ( int32_t y = 0; y < CHUNK_SIZE; y++ )
 			{
-				it++;
+				for ( int32_t x = 0; x < CHUNK_SIZE; x++ )
+				{
+					snapshot.light[ ChunkSnapshot::index( x, y, z ) ] =
+					    chunk.get_light( { x, y, z } );
+				}
 			}
 		}
 	}
 
+	// apron comes from all 26 neighbors, edges and corners are read by
+	// ambient occlusion
+	for ( int32_t i = 0; i < 27; i++ )
+	{
+		glm::ivec3 offset( i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1 );
+
+		if ( offset == glm::ivec3( 0 ) )
+		{
+			continue;
+		}
+
+		const Chunk* neighbor = find_chunk( chunk.position + offset );
+
+		if ( neighbor == nullptr )
+		{
+			continue;
+		}
+
+		// part of apron touching neighbor, a plane, row or single voxel
+		glm::ivec3 from, to;
+
+		for ( int32_t a = 0; a < 3; a++ )
+		{
+			from[ a ] = offset[ a ] < 0   ? -1
+			            : offset[ a ] > 0 ? CHUNK_SIZE
+			                              : 0;
+			to[ a ]   = offset[ a ] == 0 ? CHUNK_SIZE - 1 : from[ a ];
+		}
+
+		glm::ivec3 dst;
+
+		for ( dst.z = from.z; dst.z <= to.z; dst.z++ )
+		{
+			for ( dst.y = from.y; dst.y <= to.y; dst.y++ )
+			{
+				for ( dst.x = from.x; dst.x <= to.x; dst.x++ )
+				{
+					glm::ivec3 src = dst - offset * CHUNK_SIZE;
+					int32_t    idx =
+					    ChunkSnapshot::index( dst.x, dst.y, dst.z );
+					snapshot.voxels[ idx ] = neighbor->get_voxel( src );
+					snapshot.light[ idx ]  = neighbor->get_light( src );
+				}
+			}
+		}
+	}
+}
+
+void
+ChunkManager::evict_columns( const glm::ivec2& center )
+{
+	for ( int32_t i = 0; i < COLUMN_EVICTIONS_PER_FRAME; i++ )
+	{
+		ChunkColumn* column = resident_columns.back();
+
+		// rest of the list was used this frame
+		if ( column == nullptr || column->last_access_frame == frame_count )
+		{
+			return;
+		}
+
+		glm::ivec2 offset = glm::abs( column->position - center );
+		bool       far =
+		    std::max( offset.x, offset.y ) > CHUNKS_UNLOAD_DISTANCE;
+
+		// pending columns are still written by workers, columns inside
+		// unload distance stay while budget allows. look at them again
+		// after the rest of the list
+		if ( column->state == ChunkColumn::PENDING ||
+		     ( !far && voxel_bytes <= VOXEL_MEMORY_BUDGET ) )
+		{
+			resident_columns.touch( column );
+			continue;
+		}
+
+		columns.erase( column->position );
+		unload_column( column );
+	}
+}
+
+void
+ChunkManager::update_visible_chunks( const glm::vec3& position,
+                                     const glm::vec3& direction )
+{
+	chunk_pool.collect( CHUNK_RELEASES_PER_FRAME );
+
+	ready_columns.clear();
+	column_generator.collect( ready_columns );
+
+	for ( ChunkColumn* column : ready_columns )
+	{
+		for ( const Chunk* chunk : column->sections )
+		{
+			if ( chunk != nullptr )
+			{
+				column->memory_bytes += chunk->memory_usage();
+			}
+		}
+		voxel_bytes += column->memory_bytes;
+
+		invalidate_neighbors( column->position );
+		light_engine.join_column( *column );
+		// new sections have to be pushed even if player did not move
+		visible_changed |= column->in_view;
+	}
+
+	relight();
+
 	mesh_generator->reset();
 
 	glm::ivec3 chunk_position;
 	to_chunk_position( chunk_position, position );
 
-	if ( need_update_chunks( chunk_position ) == false )
+	update_view( glm::ivec2( chunk_position.x, chunk_position.z ) );
+
+	if ( visible_changed )
+	{
+		rebuild_visible_chunks();
+	}
+
+	flush_dirty_chunks();
+
+	// need this for face removing proper work
+	mesh_generator->push_chunks( visible_chunks );
+
+	// far terrain fills hole exactly where chunks above are drawn
+	lod_terrain.update( view_center );
+	lod_terrain.push_meshes( *mesh_generator );
+
+	// looking straight up or down nothing is in front in particular
+	glm::vec2 forward( direction.x, direction.z );
+	float     length = glm::length( forward );
+	forward          = length > 0.001f ? forward / length : glm::vec2( 0.0f );
+
+	request_columns( forward );
+	update_fill_time( forward );
+
+	evict_columns( view_center );
+	frame_count++;
+}
+
+static inline int32_t
+floor_mod( int32_t a, int32_t b )
+{
+	return ( a % b + b ) % b;
+}
+
+ChunkColumn*&
+ChunkManager::view_slot( const glm::ivec2& position )
+{
+	return view_columns[ floor_mod( position.x, VIEW_SIZE ) +
+	                     VIEW_SIZE * floor_mod( position.y, VIEW_SIZE ) ];
+}
+
+bool
+ChunkManager::is_in_view( const glm::ivec2& position ) const
+{
+	glm::ivec2 offset = position - view_center;
+
+	return view_valid && offset.x >= -CHUNKS_IN_RENDER_DISTANCE &&
+	       offset.x < CHUNKS_IN_RENDER_DISTANCE &&
+	       offset.y >= -CHUNKS_IN_RENDER_DISTANCE &&
+	       offset.y < CHUNKS_IN_RENDER_DISTANCE;
+}
+
+// calls f for every column around center a which is not around center b,
+// rows fully inside b are skipped in one step
+template <typename F>
+static inline void
+for_each_view_difference( const glm::ivec2& a,
+                          const glm::ivec2& b,
+                          bool              b_valid,
+                          F                 f )
+{
+	for ( int32_t z = a.y - CHUNKS_IN_RENDER_DISTANCE;
+	      z < a.y + CHUNKS_IN_RENDER_DISTANCE;
+	      z++ )
+	{
+		bool row_overlaps = b_valid && z >= b.y - CHUNKS_IN_RENDER_DISTANCE &&
+		                    z < b.y + CHUNKS_IN_RENDER_DISTANCE;
+
+		for ( int32_t x = a.x - CHUNKS_IN_RENDER_DISTANCE;
+		      x < a.x + CHUNKS_IN_RENDER_DISTANCE;
+		      x++ )
+		{
+			if ( row_overlaps && x >= b.x - CHUNKS_IN_RENDER_DISTANCE &&
+			     x < b.x + CHUNKS_IN_RENDER_DISTANCE )
+			{
+				x = b.x + CHUNKS_IN_RENDER_DISTANCE - 1;
+				continue;
+			}
+
+			f( glm::ivec2( x, z ) );
+		}
+	}
+}
+
+void
+ChunkManager::update_view( const glm::ivec2& center )
+{
+	if ( view_valid && center == view_center )
 	{
 		return;
 	}
 
-	std::list<Chunk*> chunks_to_push;
+	// leaving first, entering column may take the slot of leaving one
+	if ( view_valid )
+	{
+		for_each_view_difference( view_center,
+		                          center,
+		                          true,
+		                          [ & ]( const glm::ivec2& position )
+		                          { leave_view( position ); } );
+	}
+
+	glm::ivec2 old_center = view_center;
+	bool       old_valid  = view_valid;
+	view_center           = center;
+	view_valid            = true;
+
+	for_each_view_difference( center,
+	                          old_center,
+	                          old_valid,
+	                          [ & ]( const glm::ivec2& position )
+	                          { enter_view( position ); } );
+
+	visible_changed = true;
+}
+
+void
+ChunkManager::enter_view( const glm::ivec2& position )
+{
+	ChunkColumn* column = columns.find( position );
+
+	if ( column == nullptr )
+	{
+		// priority is set when requests are ranked
+		load_requests.push_back( { position, 0.0f } );
+	}
+	else
+	{
+		column->in_view = true;
+		resident_columns.remove( column );
+	}
+
+	view_slot( position ) = column;
+
+	if ( !filling_view &&
+	     ( column == nullptr || column->state == ChunkColumn::PENDING ) )
+	{
+		filling_view = true;
+		front_filled = false;
+		fill_start   = Clock::now();
+	}
+}
+
+void
+ChunkManager::leave_view( const glm::ivec2& position )
+{
+	ChunkColumn*& slot = view_slot( position );
+
+	// queued load requests of this column are dropped when ranked
+	if ( slot != nullptr )
+	{
+		slot->in_view           = false;
+		slot->last_access_frame = frame_count;
+		resident_columns.push_front( slot );
+		slot = nullptr;
+	}
+}
+
+void
+ChunkManager::rebuild_visible_chunks()
+{
+	visible_chunks.clear();
 
 	for ( int32_t z = -CHUNKS_IN_RENDER_DISTANCE; z < CHUNKS_IN_RENDER_DISTANCE;
 	      z++ )
@@ -60,37 +627,176 @@ ChunkManager::update_visible_chunks( const glm::vec3& position )
 		      x < CHUNKS_IN_RENDER_DISTANCE;
 		      x++ )
 		{
-			glm::ivec3 spawn_position = chunk_position + glm::ivec3( x, 0, z );
-			spawn_position.y          = -2;
+			const ChunkColumn* column =
+			    view_slot( view_center + glm::ivec2( x, z ) );
 
-			bool   new_chunk = chunks.find( spawn_position ) == chunks.cend();
-			Chunk& chunk     = chunks[ spawn_position ];
+			// pushed on the frame it is collected
+			if ( column == nullptr || column->state == ChunkColumn::PENDING )
+			{
+				continue;
+			}
 
-			if ( new_chunk )
+			for ( Chunk* chunk : column->sections )
 			{
-				chunk.init( spawn_position, this, frame_count );
+				if ( chunk != nullptr )
+				{
+					visible_chunks.push_back( chunk );
+				}
 			}
+		}
+	}
+
+	visible_changed = false;
+}
+
+// lower loads first, distance in columns stretched by angle to camera
+static inline float
+load_priority( const glm::vec2 offset, const glm::vec2 forward )
+{
+	float distance = glm::length( offset );
+
+	if ( distance < 1.0f )
+	{
+		return 0.0f;
+	}
+
+	float facing = glm::dot( offset / distance, forward );
+
+	return distance * ( 1.0f + VIEW_PRIORITY_WEIGHT * ( 1.0f - facing ) );
+}
+
+static inline bool
+is_in_front( const glm::vec2 offset, const glm::vec2 forward )
+{
+	float distance = glm::length( offset );
 
-			chunk.last_access_frame = frame_count;
-			chunks_to_push.push_back( &chunk );
+	return distance < 1.0f ||
+	       glm::dot( offset / distance, forward ) >= VIEW_CONE_COS;
+}
+
+void
+ChunkManager::request_columns( const glm::vec2& forward )
+{
+	if ( load_requests.empty() )
+	{
+		return;
+	}
+
+	// camera turned or moved since requests were queued, rank them again
+	// and drop those which left view or were requested already
+	size_t kept = 0;
+
+	for ( LoadRequest request : load_requests )
+	{
+		if ( !is_in_view( request.position ) ||
+		     view_slot( request.position ) != nullptr )
+		{
+			continue;
+		}
+
+		glm::ivec2 offset = request.position - view_center;
+
+		if ( load_order == LoadOrder::VIEW )
+		{
+			request.priority = load_priority( glm::vec2( offset ), forward );
 		}
+		else
+		{
+			request.priority =
+			    float( ( offset.y + CHUNKS_IN_RENDER_DISTANCE ) * VIEW_SIZE +
+			           offset.x + CHUNKS_IN_RENDER_DISTANCE );
+		}
+
+		load_requests[ kept++ ] = request;
 	}
 
-	// need this for face removing proper work
-	mesh_generator->push_chunks( chunks_to_push );
+	load_requests.resize( kept );
 
-	last_update_position     = chunk_position;
-	world_changed_last_frame = false;
-	frame_count++;
+	auto later = []( const LoadRequest& a, const LoadRequest& b )
+	{ return a.priority > b.priority; };
+
+	std::make_heap( load_requests.begin(), load_requests.end(), later );
+
+	// rest of missing columns is requested on later frames
+	for ( int32_t i = 0; i < COLUMN_REQUESTS_PER_FRAME &&
+	                     column_generator.can_request() &&
+	                     !load_requests.empty(); )
+	{
+		std::pop_heap( load_requests.begin(), load_requests.end(), later );
+		LoadRequest request = load_requests.back();
+		load_requests.pop_back();
+
+		// same column may be queued twice when it left and came back
+		if ( view_slot( request.position ) == nullptr )
+		{
+			request_column( request.position );
+			i++;
+		}
+	}
+}
+
+void
+ChunkManager::update_fill_time( const glm::vec2& forward )
+{
+	if ( !filling_view )
+	{
+		return;
+	}
+
+	size_t missing       = 0;
+	size_t missing_front = 0;
+
+	for ( int32_t z = -CHUNKS_IN_RENDER_DISTANCE; z < CHUNKS_IN_RENDER_DISTANCE;
+	      z++ )
+	{
+		for ( int32_t x = -CHUNKS_IN_RENDER_DISTANCE;
+		      x < CHUNKS_IN_RENDER_DISTANCE;
+		      x++ )
+		{
+			const ChunkColumn* column =
+			    view_slot( view_center + glm::ivec2( x, z ) );
+
+			if ( column == nullptr || column->state == ChunkColumn::PENDING )
+			{
+				missing++;
+				missing_front += is_in_front( glm::vec2( x, z ), forward );
+			}
+		}
+	}
+
+	streaming_stats.missing_columns       = missing;
+	streaming_stats.missing_front_columns = missing_front;
+
+	double elapsed_ms =
+	    std::chrono::duration<double, std::milli>( Clock::now() - fill_start )
+	        .count();
+
+	if ( missing_front == 0 && !front_filled )
+	{
+		front_filled                       = true;
+		streaming_stats.last_fill_front_ms = elapsed_ms;
+	}
+
+	if ( missing == 0 )
+	{
+		filling_view                      = false;
+		streaming_stats.last_fill_view_ms = elapsed_ms;
+	}
 }
 
 Voxel::Type
 ChunkManager::get_voxel( const glm::ivec3& position ) const
 {
+	if ( position.y < 0 || position.y >= WORLD_HEIGHT )
+	{
+		return Voxel::AIR;
+	}
+
 	glm::ivec3 chunk_position;
 	to_chunk_position( chunk_position, position );
-	auto it = chunks.find( chunk_position );
-	if ( it == chunks.cend() )
+	ChunkColumn* column = find_generated_column(
+	    glm::ivec2( chunk_position.x, chunk_position.z ) );
+	if ( column == nullptr )
 	{
 		return Voxel::AIR;
 	}
@@ -98,73 +804,286 @@ ChunkManager::get_voxel( const glm::ivec3& position ) const
 	{
 		glm::ivec3 local;
 		global_voxel_to_local( local, position );
-		it->second.last_access_frame = frame_count;
-		return it->second.get_voxel( local );
+		local.y                   = position.y;
+		touch_column( column );
+		return column->get_voxel( local );
 	}
 }
 
-void
-ChunkManager::ensure_neighbors( const glm::ivec3& position,
-                                const glm::ivec3& chunk_position )
+static inline int32_t
+floor_div( int32_t a, int32_t b )
+{
+	return a / b - ( a % b < 0 );
+}
+
+template <typename F>
+size_t
+ChunkManager::edit_box( glm::ivec3 min, glm::ivec3 max, F edit )
 {
-	glm::ivec3 neighbor_position;
+	min.y = std::max( min.y, 0 );
+	max.y = std::min( max.y, WORLD_HEIGHT - 1 );
+
+	if ( min.x > max.x || min.y > max.y || min.z > max.z )
+	{
+		return 0;
+	}
+
+	glm::ivec3 min_chunk( floor_div( min.x, CHUNK_SIZE ),
+	                      min.y / CHUNK_SIZE,
+	                      floor_div( min.z, CHUNK_SIZE ) );
+	glm::ivec3 max_chunk( floor_div( max.x, CHUNK_SIZE ),
+	                      max.y / CHUNK_SIZE,
+	                      floor_div( max.z, CHUNK_SIZE ) );
 
-	if ( position.x == 0 )
-		neighbor_position = chunk_position - glm::ivec3( 1, 0, 0 );
+	size_t changed = 0;
 
-	if ( position.x == CHUNK_SIZE - 1 )
-		neighbor_position = chunk_position + glm::ivec3( 1, 0, 0 );
+	for ( int32_t cz = min_chunk.z; cz <= max_chunk.z; cz++ )
+	{
+		for ( int32_t cx = min_chunk.x; cx <= max_chunk.x; cx++ )
+		{
+			ChunkColumn* column = find_generated_column( { cx, cz } );
 
-	if ( position.z == 0 )
-		neighbor_position = chunk_position - glm::ivec3( 0, 0, 1 );
+			// edits outside of loaded area would be lost on generation
+			if ( column == nullptr )
+			{
+				continue;
+			}
 
-	if ( position.z == CHUNK_SIZE - 1 )
-		neighbor_position = chunk_position + glm::ivec3( 0, 0, 1 );
+			touch_column( column );
+			added_edits.clear();
 
-	// TODO: WORLD HEIGHT > 1
+			for ( int32_t cy = min_chunk.y; cy <= max_chunk.y; cy++ )
+			{
+				glm::ivec3 chunk_position( cx, cy, cz );
+				glm::ivec3 origin = chunk_position * CHUNK_SIZE;
+				glm::ivec3 lo     = glm::max( min - origin, glm::ivec3( 0 ) );
+				glm::ivec3 hi =
+				    glm::min( max - origin, glm::ivec3( CHUNK_SIZE - 1 ) );
 
-	//	if ( position.y == 0 )
-	//		neighbor_position = chunk_position - glm::ivec3( 0, 1, 0 );
+				Chunk* chunk = column->sections[ cy ];
+				// palette may grow or section come and go
+				size_t old_bytes = chunk != nullptr ? chunk->memory_usage() : 0;
 
-	//	if ( position.y == CHUNK_SIZE - 1 )
-	//		neighbor_position = chunk_position + glm::ivec3( 0, 1, 0 );
+				glm::ivec3 changed_lo( CHUNK_SIZE );
+				glm::ivec3 changed_hi( -1 );
 
-	auto it = chunks.find( neighbor_position );
+				// x innermost, it is contiguous in storage
+				for ( int32_t y = lo.y; y <= hi.y; y++ )
+				{
+					for ( int32_t z = lo.z; z <= hi.z; z++ )
+					{
+						for ( int32_t x = lo.x; x <= hi.x; x++ )
+						{
+							glm::ivec3  local( x, y, z );
+							Voxel::Type old_voxel =
+							    chunk != nullptr ? chunk->get_voxel( local )
+							                     : Voxel::AIR;
+							Voxel::Type voxel =
+							    edit( origin + local, old_voxel );
 
-	if ( it != chunks.end() )
-	{
-		it->second.modified          = true;
-		it->second.last_access_frame = frame_count;
-		mesh_generator->push_chunk( it->second );
+							if ( voxel == old_voxel )
+							{
+								continue;
+							}
+
+							if ( chunk == nullptr )
+							{
+								// first write into elided section, pooled
+								// chunk is already AIR
+								chunk = chunk_pool.acquire();
+								chunk->attach( chunk_position, this, column );
+								column->sections[ cy ] = chunk;
+								visible_changed        = true;
+							}
+
+							chunk->set_voxel( local, voxel );
+							light_engine.update_voxel(
+							    origin + local, old_voxel, voxel );
+							added_edits.push_back(
+							    { ColumnEdits::index( { x, origin.y + y, z } ),
+							      voxel } );
+
+							changed_lo = glm::min( changed_lo, local );
+							changed_hi = glm::max( changed_hi, local );
+						}
+					}
+				}
+
+				if ( changed_hi.x < 0 )
+				{
+					continue;
+				}
+
+				size_t new_bytes = 0;
+
+				if ( chunk->is_elidable() )
+				{
+					// keep all AIR sections under open sky unallocated
+					release_section( chunk );
+				}
+				else
+				{
+					new_bytes = chunk->memory_usage();
+					mark_dirty( chunk_position );
+				}
+
+				// chunk may shrink, an unsigned difference would wrap
+				column->memory_bytes -= old_bytes;
+				column->memory_bytes += new_bytes;
+				voxel_bytes -= old_bytes;
+				voxel_bytes += new_bytes;
+
+				// neighbors sharing a changed border, edge or corner keep it
+				// in their apron, faces and ambient occlusion depend on it
+				glm::ivec3 near_lo( 0 );
+				glm::ivec3 near_hi( 0 );
+
+				for ( int32_t axis = 0; axis < 3; axis++ )
+				{
+					near_lo[ axis ] = changed_lo[ axis ] == 0 ? -1 : 0;
+					near_hi[ axis ] =
+					    changed_hi[ axis ] == CHUNK_SIZE - 1 ? 1 : 0;
+				}
+
+				for ( int32_t dz = near_lo.z; dz <= near_hi.z; dz++ )
+				{
+					for ( int32_t dy = near_lo.y; dy <= near_hi.y; dy++ )
+					{
+						for ( int32_t dx = near_lo.x; dx <= near_hi.x; dx++ )
+						{
+							if ( dx != 0 || dy != 0 || dz != 0 )
+							{
+								mark_dirty( chunk_position +
+								            glm::ivec3( dx, dy, dz ) );
+							}
+						}
+					}
+				}
+			}
+
+			if ( !added_edits.empty() )
+			{
+				column->edited = true;
+				changed += added_edits.size();
+				column->edits.merge( added_edits );
+			}
+		}
 	}
+
+	relight();
+
+	return changed;
 }
 
 void
 ChunkManager::set_voxel( const glm::ivec3& position, Voxel::Type voxel )
 {
-	glm::ivec3 chunk_position;
-	to_chunk_position( chunk_position, position );
-	auto       it = chunks.find( chunk_position );
-	glm::ivec3 local;
-	global_voxel_to_local( local, position );
+	edit_box( position,
+	          position,
+	          [ voxel ]( const glm::ivec3&, Voxel::Type ) { return voxel; } );
+}
 
-	if ( it != chunks.cend() )
-	{
-		it->second.last_access_frame = frame_count;
-		it->second.set_voxel( local, voxel );
-		mesh_generator->push_chunk( it->second );
-		if ( is_transparent( voxel ) )
-		{
-			ensure_neighbors( local, chunk_position );
-		}
-	}
-	else if ( voxel != Voxel::AIR )
+size_t
+ChunkManager::fill_box( const glm::ivec3& min,
+                        const glm::ivec3& max,
+                        Voxel::Type       voxel )
+{
+	return edit_box( min,
+	                 max,
+	                 [ voxel ]( const glm::ivec3&, Voxel::Type )
+	                 { return voxel; } );
+}
+
+size_t
+ChunkManager::fill_sphere( const glm::vec3& center,
+                           float            radius,
+                           Voxel::Type      voxel )
+{
+	glm::ivec3 min;
+	glm::ivec3 max;
+	to_voxel_position( min, center - radius );
+	to_voxel_position( max, center + radius );
+
+	float radius_squared = radius * radius;
+
+	// voxel is inside when its center is
+	return edit_box( min,
+	                 max,
+	                 [ & ]( const glm::ivec3& position, Voxel::Type old_voxel )
+	                 {
+		                 glm::vec3 d = glm::vec3( position ) + 0.5f - center;
+		                 return glm::dot( d, d ) <= radius_squared ? voxel
+		                                                           : old_voxel;
+	                 } );
+}
+
+size_t
+ChunkManager::replace_box( const glm::ivec3& min,
+                           const glm::ivec3& max,
+                           Voxel::Type       from,
+                           Voxel::Type       to )
+{
+	return edit_box( min,
+	                 max,
+	                 [ from, to ]( const glm::ivec3&, Voxel::Type old_voxel )
+	                 { return old_voxel == from ? to : old_voxel; } );
+}
+
+size_t
+ChunkManager::copy_buffer( const glm::ivec3& origin,
+                           const glm::ivec3& size,
+                           const Voxel::Type* voxels )
+{
+	return edit_box( origin,
+	                 origin + size - 1,
+	                 [ & ]( const glm::ivec3& position, Voxel::Type )
+	                 {
+		                 glm::ivec3 p = position - origin;
+		                 return voxels[ p.x + size.x * ( p.z + size.z * p.y ) ];
+	                 } );
+}
+
+ChunkMemoryReport
+ChunkManager::get_memory_report() const
+{
+	ChunkMemoryReport report = {};
+	report.column_count      = columns.size();
+
+	columns.for_each(
+	    [ & ]( const ChunkColumn* column )
+	    {
+		    if ( column->state == ChunkColumn::PENDING )
+		    {
+			    return;
+		    }
+
+		    report.edit_count += column->edits.size();
+		    report.edit_bytes += column->edits.memory_usage();
+
+		    for ( const Chunk* chunk : column->sections )
+		    {
+			    if ( chunk == nullptr )
+			    {
+				    report.empty_sections++;
+				    continue;
+			    }
+
+			    report.chunk_count++;
+			    report.total_bytes += chunk->memory_usage();
+		    }
+	    } );
+
+	if ( report.chunk_count != 0 )
 	{
-		Chunk& chunk        = chunks[ chunk_position ];
-		chunk.chunk_manager = this;
-		chunk.data.fill( Voxel::AIR );
-		chunk.set_voxel( local, voxel );
-		chunk.last_access_frame = frame_count;
-		mesh_generator->push_chunk( chunk );
+		report.bytes_per_chunk = report.total_bytes / report.chunk_count;
 	}
+
+	report.budget_voxel_bytes = voxel_bytes;
+	report.budget_mesh_bytes  = mesh_generator->get_cache_bytes();
+
+	report.flat_bytes = report.chunk_count *
+	                    ( sizeof( Chunk ) - sizeof( VoxelStorage ) +
+	                      sizeof( FlatVoxelStorage ) );
+
+	return report;
 }
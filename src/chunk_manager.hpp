@@ -1,42 +1,312 @@
 #pragma once
 
-#define GLM_ENABLE_EXPERIMENTAL
-#include <unordered_map>
-#include <list>
-#include <glm/gtx/hash.hpp>
+#include <array>
+#include <chrono>
 #include "chunk.hpp"
+#include "chunk_column.hpp"
+#include "column_table.hpp"
+#include "chunk_pool.hpp"
+#include "chunk_snapshot.hpp"
+#include "column_generator.hpp"
+#include "heightmap_cache.hpp"
+#include "light_engine.hpp"
+#include "lod_terrain.hpp"
+#include "world_storage.hpp"
+#include "worker_pool.hpp"
+#include "lru_list.hpp"
 
 class MeshGenerator;
 
+struct StreamingStats
+{
+	// columns inside render distance not generated yet
+	size_t missing_columns;
+	size_t missing_front_columns;
+	// from first missing column until everything in front of camera and
+	// everything in render distance became visible
+	double last_fill_front_ms;
+	double last_fill_view_ms;
+};
+
+struct RemeshStats
+{
+	// chunks marked dirty by edits and streaming
+	size_t invalidations;
+	// dirty chunks in view remeshed when dirty set was flushed
+	size_t remeshes;
+	// invalidations folded into another one of same chunk and frame
+	size_t remeshes_avoided;
+};
+
+struct ChunkMemoryReport
+{
+	size_t column_count;
+	size_t chunk_count;
+	// sections skipped because they contain only AIR
+	size_t empty_sections;
+	// chunk structs plus voxel storage owned by them
+	size_t total_bytes;
+	size_t bytes_per_chunk;
+	// what the same chunks would take with flat voxel arrays
+	size_t flat_bytes;
+	// player edits kept on top of generated terrain
+	size_t edit_count;
+	size_t edit_bytes;
+	// what budgets are checked against
+	size_t budget_voxel_bytes;
+	size_t budget_mesh_bytes;
+};
+
 class ChunkManager
 {
+public:
+	enum class LoadOrder
+	{
+		// row by row over the grid, kept for comparing fill times
+		GRID,
+		// nearest first, columns in front of camera before those behind
+		VIEW
+	};
+
 private:
+	using Clock = std::chrono::steady_clock;
+
+	struct LoadRequest
+	{
+		glm::ivec2 position;
+		float      priority;
+	};
+
+	static constexpr int32_t VIEW_SIZE = 2 * CHUNKS_IN_RENDER_DISTANCE;
+
 	MeshGenerator* mesh_generator;
 
-	glm::ivec3 last_update_position;
-	bool       world_changed_last_frame;
+	ColumnTable     columns;
+	ChunkPool       chunk_pool;
+	HeightmapCache  heightmap_cache;
+	WorldStorage    world_storage;
+	ColumnGenerator column_generator;
+	LightEngine     light_engine;
+	LodTerrain      lod_terrain;
+	// only reads chunks, so batches may run on a const manager
+	mutable WorkerPool raycast_workers;
+
+	std::vector<ChunkColumn*> ready_columns;
+
+	// touched by lookups too, which are const
+	mutable LruList<ChunkColumn> resident_columns;
+	size_t                       voxel_bytes;
+
+	// columns in render distance by position modulo VIEW_SIZE, so slots of
+	// row leaving view are reused by row entering it. nullptr until column
+	// is requested
+	std::array<ChunkColumn*, VIEW_SIZE * VIEW_SIZE> view_columns;
+	glm::ivec2                                      view_center;
+	bool                                            view_valid;
+	// sections of generated columns in view, rebuilt only when it changes
+	std::vector<Chunk*> visible_chunks;
+	bool                visible_changed;
+
+	LoadOrder                load_order;
+	std::vector<LoadRequest> load_requests;
+	StreamingStats           streaming_stats;
+	bool                     filling_view;
+	bool                     front_filled;
+	Clock::time_point        fill_start;
+
+	std::vector<glm::ivec3> dirty_chunks;
+	RemeshStats             remesh_stats;
 
-	std::unordered_map<glm::ivec3, Chunk> chunks;
+	// scratch of edit_box
+	std::vector<ColumnEdits::Edit> added_edits;
 
 	size_t frame_count;
 
+	// column is inserted right away but stays PENDING until generated
+	void
+	request_column( const glm::ivec2& position );
+
+	// nullptr for columns still owned by generation workers
+	ChunkColumn*
+	find_generated_column( const glm::ivec2& position ) const;
+
+	void
+	touch_column( ChunkColumn* column ) const;
+
+	ChunkColumn*&
+	view_slot( const glm::ivec2& position );
+
 	bool
-	need_update_chunks( const glm::ivec3& ) const;
+	is_in_view( const glm::ivec2& position ) const;
+
+	// touches only columns entering or leaving render distance, nothing
+	// while center stays in the same chunk
+	void
+	update_view( const glm::ivec2& center );
+
+	void
+	enter_view( const glm::ivec2& position );
+
+	void
+	leave_view( const glm::ivec2& position );
+
+	void
+	rebuild_visible_chunks();
+
+	// hands best load requests to generator within per frame budget
+	void
+	request_columns( const glm::vec2& forward );
+
+	// counts missing columns only while view is being filled
+	void
+	update_fill_time( const glm::vec2& forward );
 
+	// unloads a bounded number of columns from least recently used end
 	void
-	ensure_neighbors( const glm::ivec3& position,
-	                  const glm::ivec3& chunk_position );
+	evict_columns( const glm::ivec2& center );
+
+	void
+	unload_column( ChunkColumn* column );
+
+	// saves edits and frees column and its sections, nothing else is
+	// updated
+	void
+	release_column( ChunkColumn* column );
+
+	// section is all AIR under open sky again, column drops it
+	void
+	release_section( Chunk* chunk );
+
+	// propagates queued light and remeshes chunks it reached
+	void
+	relight();
+
+	// neighbors cached meshes depend on this column border
+	void
+	invalidate_neighbors( const glm::ivec2& position );
+
+	// calls edit( position, old voxel ) for every voxel of box clipped to
+	// world height and writes what it returns. min and max are inclusive
+	template <typename F>
+	size_t
+	edit_box( glm::ivec3 min, glm::ivec3 max, F edit );
+
+	// chunk is remeshed on next flush, once however often it is marked
+	void
+	mark_dirty( const glm::ivec3& chunk_position );
+
+	// remeshes dirty chunks in view in position order, others keep
+	// modified flag and are remeshed when pushed
+	void
+	flush_dirty_chunks();
 
 public:
+	// edited columns are saved to and loaded from region files in
+	// world_directory
+	void
+	init( MeshGenerator*, const std::string& world_directory );
+
+	void
+	shutdown();
+
 	void
-	init( MeshGenerator* );
+	update_visible_chunks( const glm::vec3& position,
+	                       const glm::vec3& direction );
 
 	void
-	update_visible_chunks( const glm::vec3& position );
+	set_load_order( LoadOrder order )
+	{
+		load_order = order;
+	}
 
 	Voxel::Type
 	get_voxel( const glm::ivec3& ) const;
 
 	void
 	set_voxel( const glm::ivec3& position, Voxel::Type voxel );
+
+	// edits are visible after next update_visible_chunks, which remeshes
+	// each affected chunk once. bulk edits return number of changed
+	// voxels, columns not generated yet are skipped
+	size_t
+	fill_box( const glm::ivec3& min, const glm::ivec3& max, Voxel::Type );
+
+	size_t
+	fill_sphere( const glm::vec3& center, float radius, Voxel::Type );
+
+	size_t
+	replace_box( const glm::ivec3& min,
+	             const glm::ivec3& max,
+	             Voxel::Type       from,
+	             Voxel::Type       to );
+
+	// voxels[ x + size.x * ( z + size.z * y ) ] goes to origin + ( x, y, z ),
+	// AIR in buffer is written too
+	size_t
+	copy_buffer( const glm::ivec3&  origin,
+	             const glm::ivec3&  size,
+	             const Voxel::Type* voxels );
+
+	Chunk*
+	find_chunk( const glm::ivec3& chunk_position ) const;
+
+	void
+	build_snapshot( const Chunk& chunk, ChunkSnapshot& snapshot ) const;
+
+	ChunkMemoryReport
+	get_memory_report() const;
+
+	ChunkPoolStats
+	get_pool_stats() const
+	{
+		return chunk_pool.get_stats();
+	}
+
+	const GenerationStats&
+	get_generation_stats() const
+	{
+		return column_generator.get_stats();
+	}
+
+	HeightmapCacheStats
+	get_heightmap_cache_stats() const
+	{
+		return heightmap_cache.get_stats();
+	}
+
+	WorldStorageStats
+	get_storage_stats() const
+	{
+		return world_storage.get_stats();
+	}
+
+	const LodStats&
+	get_lod_stats() const
+	{
+		return lod_terrain.get_stats();
+	}
+
+	const LightStats&
+	get_light_stats() const
+	{
+		return light_engine.get_stats();
+	}
+
+	const RemeshStats&
+	get_remesh_stats() const
+	{
+		return remesh_stats;
+	}
+
+	const StreamingStats&
+	get_streaming_stats() const
+	{
+		return streaming_stats;
+	}
+
+	WorkerPool&
+	get_raycast_workers() const
+	{
+		return raycast_workers;
+	}
 };
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include "chunk_pool.hpp"
+
+void
+ChunkPool::init( size_t reserve_chunks, ReleaseMode mode )
+{
+	release_mode = mode;
+	stats        = {};
+
+	while ( stats.capacity < reserve_chunks )
+	{
+		add_slab();
+	}
+}
+
+void
+ChunkPool::shutdown()
+{
+	for ( Chunk* slab : slabs )
+	{
+		delete[] slab;
+	}
+
+	slabs.clear();
+	free_list.clear();
+	pending.clear();
+	stats = {};
+}
+
+void
+ChunkPool::add_slab()
+{
+	// default constructed chunks are already filled with AIR
+	Chunk* slab = new Chunk[ CHUNKS_PER_SLAB ];
+	slabs.push_back( slab );
+
+	free_list.reserve( free_list.size() + CHUNKS_PER_SLAB );
+	// reverse order so chunks are handed out in address order
+	for ( size_t i = CHUNKS_PER_SLAB; i > 0; i-- )
+	{
+		free_list.push_back( &slab[ i - 1 ] );
+	}
+
+	stats.slab_count++;
+	stats.capacity += CHUNKS_PER_SLAB;
+}
+
+Chunk*
+ChunkPool::acquire()
+{
+	std::lock_guard<std::mutex> lock( mutex );
+
+	if ( free_list.empty() )
+	{
+		// rather finish pending releases than grow the pool
+		collect_locked( pending.size() );
+	}
+
+	if ( free_list.empty() )
+	{
+		add_slab();
+	}
+
+	Chunk* chunk = free_list.back();
+	free_list.pop_back();
+
+	stats.in_use++;
+	stats.high_water_mark = std::max( stats.high_water_mark, stats.in_use );
+
+	return chunk;
+}
+
+void
+ChunkPool::release( Chunk* chunk )
+{
+	std::lock_guard<std::mutex> lock( mutex );
+
+	stats.in_use--;
+
+	if ( release_mode == ReleaseMode::IMMEDIATE )
+	{
+		recycle( chunk );
+		free_list.push_back( chunk );
+	}
+	else
+	{
+		pending.push_back( chunk );
+		stats.pending_release = pending.size();
+	}
+}
+
+void
+ChunkPool::collect( size_t max_count )
+{
+	std::vector<Chunk*> chunks;
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		size_t count = std::min( max_count, pending.size() );
+		chunks.assign( pending.end() - count, pending.end() );
+		pending.resize( pending.size() - count );
+		stats.pending_release = pending.size();
+	}
+
+	// clear without holding the lock, workers may acquire meanwhile
+	for ( Chunk* chunk : chunks )
+	{
+		recycle( chunk );
+	}
+
+	std::lock_guard<std::mutex> lock( mutex );
+	free_list.insert( free_list.end(), chunks.begin(), chunks.end() );
+}
+
+void
+ChunkPool::collect_locked( size_t max_count )
+{
+	size_t count = std::min( max_count, pending.size() );
+
+	for ( size_t i = 0; i < count; i++ )
+	{
+		recycle( pending.back() );
+		free_list.push_back( pending.back() );
+		pending.pop_back();
+	}
+
+	stats.pending_release = pending.size();
+}
+
+void
+ChunkPool::recycle( Chunk* chunk )
+{
+	chunk->clear();
+	chunk->chunk_manager = nullptr;
+	chunk->column        = nullptr;
+	chunk->modified      = false;
+}
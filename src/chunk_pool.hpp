@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "chunk.hpp"
+
+struct ChunkPoolStats
+{
+	size_t slab_count;
+	size_t capacity;
+	size_t in_use;
+	size_t high_water_mark;
+	size_t pending_release;
+};
+
+// chunks are carved from preallocated slabs and recycled through a free
+// list. every chunk on the free list holds AIR only, so callers may write
+// into it right away without clearing. safe to use from generation workers
+class ChunkPool
+{
+public:
+	enum class ReleaseMode
+	{
+		IMMEDIATE,
+		// released chunks are cleared later by collect(), keeps memset off
+		// the frame which evicted them
+		DEFERRED
+	};
+
+private:
+	static constexpr size_t CHUNKS_PER_SLAB = 128;
+
+	mutable std::mutex  mutex;
+	ReleaseMode         release_mode;
+	std::vector<Chunk*> slabs;
+	std::vector<Chunk*> free_list;
+	std::vector<Chunk*> pending;
+	ChunkPoolStats      stats;
+
+	void
+	add_slab();
+
+	// clears chunk back to AIR, caller puts it on free list
+	static void
+	recycle( Chunk* chunk );
+
+	void
+	collect_locked( size_t max_count );
+
+public:
+	void
+	init( size_t reserve_chunks, ReleaseMode mode );
+
+	void
+	shutdown();
+
+	Chunk*
+	acquire();
+
+	void
+	release( Chunk* chunk );
+
+	// clears at most max_count released chunks and returns them to free list
+	void
+	collect( size_t max_count );
+
+	ChunkPoolStats
+	get_stats() const
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		return stats;
+	}
+};
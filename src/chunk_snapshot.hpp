@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <glm/glm.hpp>
+#include "constants.hpp"
+#include "voxel.hpp"
+
+// copy of chunk voxels and light with one voxel apron taken from all 26
+// neighbors. built once per remesh, mesher reads nothing else so snapshot
+// may be handed to another thread. apron of missing neighbors stays AIR.
+// far terrain uses it too, with every voxel standing for scale^3 voxels
+struct ChunkSnapshot
+{
+	static constexpr int32_t SIZE         = CHUNK_SIZE + 2;
+	static constexpr int32_t SIZE_SQUARED = SIZE * SIZE;
+	static constexpr int32_t SIZE_CUBED   = SIZE_SQUARED * SIZE;
+
+	glm::ivec3                          position;
+	std::array<Voxel::Type, SIZE_CUBED> voxels;
+	std::array<Light, SIZE_CUBED>       light;
+	// occupied rows of chunk interior, same layout as Chunk rows
+	std::array<uint16_t, CHUNK_SIZE_SQUARED> x_rows;
+	std::array<uint16_t, CHUNK_SIZE_SQUARED> z_rows;
+	// interior slices along every axis which contain at least one voxel
+	std::array<uint32_t, 3> slices;
+	bool                    empty;
+	// 1 for chunks, mesh is scaled around world origin
+	int32_t scale;
+
+	// coordinates are chunk local, -1 and CHUNK_SIZE address apron
+	static int32_t
+	index( int32_t x, int32_t y, int32_t z )
+	{
+		return ( x + 1 ) + SIZE * ( y + 1 ) + SIZE_SQUARED * ( z + 1 );
+	}
+
+	// index distance between neighbors along axis
+	static int32_t
+	stride( int32_t axis )
+	{
+		return axis == 0 ? 1 : ( axis == 1 ? SIZE : SIZE_SQUARED );
+	}
+
+	Voxel::Type
+	get_voxel( int32_t x, int32_t y, int32_t z ) const
+	{
+		return voxels[ index( x, y, z ) ];
+	}
+
+	Light
+	get_light( int32_t x, int32_t y, int32_t z ) const
+	{
+		return light[ index( x, y, z ) ];
+	}
+};
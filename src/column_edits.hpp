@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "constants.hpp"
+#include "voxel.hpp"
+
+// player edits of one column on top of generated terrain, last write to a
+// voxel wins. sorted by index so replay order does not matter
+class ColumnEdits
+{
+public:
+	struct Edit
+	{
+		// x + CHUNK_SIZE * z + CHUNK_SIZE_SQUARED * y, y is world height
+		uint16_t    index;
+		Voxel::Type voxel;
+	};
+
+	static_assert( CHUNK_SIZE_SQUARED * WORLD_HEIGHT <= 0x10000,
+	               "column voxel index must fit 16 bits" );
+
+private:
+	std::vector<Edit> edits;
+
+public:
+	static uint16_t
+	index( const glm::ivec3 position )
+	{
+		return uint16_t( position.x + CHUNK_SIZE * position.z +
+		                 CHUNK_SIZE_SQUARED * position.y );
+	}
+
+	static glm::ivec3
+	position( uint16_t index )
+	{
+		return { index % CHUNK_SIZE,
+		         index / CHUNK_SIZE_SQUARED,
+		         ( index / CHUNK_SIZE ) % CHUNK_SIZE };
+	}
+
+	// x and z are local to column, y is world height
+	void
+	set( const glm::ivec3 position, Voxel::Type voxel )
+	{
+		uint16_t i  = index( position );
+		auto     it = std::lower_bound( edits.begin(),
+		                                edits.end(),
+		                                i,
+		                                []( const Edit& edit, uint16_t i )
+		                                { return edit.index < i; } );
+
+		if ( it != edits.end() && it->index == i )
+		{
+			it->voxel = voxel;
+		}
+		else
+		{
+			edits.insert( it, Edit { i, voxel } );
+		}
+	}
+
+	// many edits at once, later edits win over earlier ones and over
+	// existing edits of same voxel. added is sorted in place
+	void
+	merge( std::vector<Edit>& added )
+	{
+		std::stable_sort( added.begin(),
+		                  added.end(),
+		                  []( const Edit& a, const Edit& b )
+		                  { return a.index < b.index; } );
+
+		std::vector<Edit> merged;
+		merged.reserve( edits.size() + added.size() );
+
+		auto it = edits.begin();
+
+		for ( size_t i = 0; i < added.size(); i++ )
+		{
+			// only last of equal indices survives
+			if ( i + 1 < added.size() &&
+			     added[ i + 1 ].index == added[ i ].index )
+			{
+				continue;
+			}
+
+			while ( it != edits.end() && it->index < added[ i ].index )
+			{
+				merged.push_back( *it++ );
+			}
+			if ( it != edits.end() && it->index == added[ i ].index )
+			{
+				it++;
+			}
+
+			merged.push_back( added[ i ] );
+		}
+
+		merged.insert( merged.end(), it, edits.end() );
+		edits.swap( merged );
+	}
+
+	void
+	clear()
+	{
+		edits.clear();
+	}
+
+	bool
+	empty() const
+	{
+		return edits.empty();
+	}
+
+	size_t
+	size() const
+	{
+		return edits.size();
+	}
+
+	size_t
+	memory_usage() const
+	{
+		return edits.capacity() * sizeof( Edit );
+	}
+
+	const std::vector<Edit>&
+	get() const
+	{
+		return edits;
+	}
+};
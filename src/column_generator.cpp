@@ -0,0 +1,233 @@
+#include <algorithm>
+#include "chunk_pool.hpp"
+#include "chunk_column.hpp"
+#include "heightmap_cache.hpp"
+#include "light_engine.hpp"
+#include "structures.hpp"
+#include "world_storage.hpp"
+#include "column_generator.hpp"
+
+static void
+generate_column( ChunkColumn*    column,
+                 ChunkManager*   chunk_manager,
+                 ChunkPool&      chunk_pool,
+                 HeightmapCache& heightmap_cache )
+{
+	Heightmap heights;
+	heightmap_cache.get( column->position, heights );
+
+	int32_t max_height =
+	    *std::max_element( heights.heights.begin(), heights.heights.end() );
+
+	// sections above the highest voxel would be all AIR, skip them
+	for ( int32_t y = 0; y * CHUNK_SIZE < max_height; y++ )
+	{
+		Chunk* chunk = chunk_pool.acquire();
+		chunk->init(
+		    glm::ivec3( column->position.x, y, column->position.y ),
+		    chunk_manager,
+		    column,
+		    heights );
+		column->sections[ y ] = chunk;
+	}
+
+	place_structures(
+	    *column, heights, chunk_manager, chunk_pool, heightmap_cache );
+}
+
+// player edits read from overlay, same section handling as
+// ChunkManager::set_voxel minus remeshing
+static void
+replay_edits( ChunkColumn* column,
+              ChunkManager* chunk_manager,
+              ChunkPool&    chunk_pool )
+{
+	for ( const ColumnEdits::Edit& edit : column->edits.get() )
+	{
+		glm::ivec3 position = ColumnEdits::position( edit.index );
+		int32_t    y        = position.y / CHUNK_SIZE;
+		Chunk*&    chunk    = column->sections[ y ];
+
+		if ( chunk == nullptr )
+		{
+			if ( edit.voxel == Voxel::AIR )
+			{
+				continue;
+			}
+
+			chunk = chunk_pool.acquire();
+			chunk->attach(
+			    glm::ivec3( column->position.x, y, column->position.y ),
+			    chunk_manager,
+			    column );
+		}
+
+		chunk->set_voxel( { position.x, position.y % CHUNK_SIZE, position.z },
+		                  edit.voxel );
+	}
+
+	// dug out sections stay unallocated like everywhere else
+	for ( Chunk*& chunk : column->sections )
+	{
+		if ( chunk != nullptr && chunk->is_empty() )
+		{
+			chunk_pool.release( chunk );
+			chunk = nullptr;
+		}
+	}
+}
+
+void
+ColumnGenerator::init( ChunkManager*   chunk_manager,
+                       ChunkPool*      chunk_pool,
+                       HeightmapCache* heightmap_cache,
+                       WorldStorage*   world_storage )
+{
+	this->chunk_manager   = chunk_manager;
+	this->chunk_pool      = chunk_pool;
+	this->heightmap_cache = heightmap_cache;
+	this->world_storage   = world_storage;
+	running               = true;
+	stats                 = {};
+	total_latency_ms      = 0.0;
+	total_load_ms         = 0.0;
+	total_generate_ms     = 0.0;
+
+	// leave one core to render thread
+	uint32_t worker_count =
+	    std::max( std::thread::hardware_concurrency(), 2u ) - 1;
+
+	for ( uint32_t i = 0; i < worker_count; i++ )
+	{
+		workers.emplace_back( &ColumnGenerator::worker_loop, this );
+	}
+}
+
+void
+ColumnGenerator::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		running = false;
+	}
+
+	condition.notify_all();
+
+	for ( std::thread& worker : workers )
+	{
+		worker.join();
+	}
+
+	// columns stay owned by chunk manager, it frees them with their sections
+	workers.clear();
+	requests.clear();
+	completed.clear();
+	collected.clear();
+}
+
+void
+ColumnGenerator::worker_loop()
+{
+	// queues are reused by every column of this worker
+	LightEngine light_engine;
+	light_engine.init( chunk_manager, chunk_pool, nullptr );
+
+	for ( ;; )
+	{
+		Job job;
+
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			condition.wait( lock,
+			                [ & ] { return !running || !requests.empty(); } );
+
+			if ( !running )
+			{
+				return;
+			}
+
+			job = requests.front();
+			requests.pop_front();
+		}
+
+		Clock::time_point start = Clock::now();
+
+		// saved columns carry player edits, generating them would lose those
+		job.loaded = world_storage->load_column( *job.column );
+
+		if ( !job.loaded )
+		{
+			generate_column( job.column,
+			                 chunk_manager,
+			                 *chunk_pool,
+			                 *heightmap_cache );
+			replay_edits( job.column, chunk_manager, *chunk_pool );
+		}
+
+		// light is not saved, loaded columns are lit again
+		light_engine.light_column( *job.column );
+
+		job.work_ms =
+		    std::chrono::duration<double, std::milli>( Clock::now() - start )
+		        .count();
+
+		std::lock_guard<std::mutex> lock( mutex );
+		completed.push_back( job );
+	}
+}
+
+void
+ColumnGenerator::request( ChunkColumn* column )
+{
+	stats.in_flight++;
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		requests.push_back( Job { column, Clock::now(), false, 0.0 } );
+	}
+
+	condition.notify_one();
+}
+
+void
+ColumnGenerator::collect( std::vector<ChunkColumn*>& ready )
+{
+	collected.clear();
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		collected.swap( completed );
+	}
+
+	Clock::time_point now = Clock::now();
+
+	for ( const Job& job : collected )
+	{
+		job.column->state = ChunkColumn::GENERATED;
+		ready.push_back( job.column );
+
+		double latency =
+		    std::chrono::duration<double, std::milli>( now - job.request_time )
+		        .count();
+
+		stats.in_flight--;
+		stats.completed++;
+		stats.last_latency_ms = latency;
+		stats.max_latency_ms  = std::max( stats.max_latency_ms, latency );
+		total_latency_ms += latency;
+		stats.average_latency_ms = total_latency_ms / stats.completed;
+
+		if ( job.loaded )
+		{
+			stats.loaded++;
+			total_load_ms += job.work_ms;
+			stats.average_load_ms = total_load_ms / stats.loaded;
+		}
+		else
+		{
+			total_generate_ms += job.work_ms;
+			stats.average_generate_ms =
+			    total_generate_ms / ( stats.completed - stats.loaded );
+		}
+	}
+}
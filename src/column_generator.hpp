@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "constants.hpp"
+
+class ChunkManager;
+class ChunkPool;
+class HeightmapCache;
+class WorldStorage;
+struct ChunkColumn;
+
+struct GenerationStats
+{
+	// requested and not collected yet
+	size_t in_flight;
+	size_t completed;
+	// from request to the frame column becomes visible to render thread
+	double last_latency_ms;
+	double average_latency_ms;
+	double max_latency_ms;
+	// worker time of columns read from region files vs generated
+	size_t loaded;
+	double average_load_ms;
+	double average_generate_ms;
+};
+
+// generates column terrain on background threads. column belongs to
+// workers from request() until collect() hands it back, render thread must
+// not touch its sections in between
+class ColumnGenerator
+{
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Job
+	{
+		ChunkColumn*      column;
+		Clock::time_point request_time;
+		// filled by worker
+		bool   loaded;
+		double work_ms;
+	};
+
+	ChunkManager*   chunk_manager;
+	ChunkPool*      chunk_pool;
+	HeightmapCache* heightmap_cache;
+	WorldStorage*   world_storage;
+
+	std::vector<std::thread> workers;
+	std::mutex               mutex;
+	std::condition_variable  condition;
+	std::deque<Job>          requests;
+	std::vector<Job>         completed;
+	// swapped with completed on collect so both keep their capacity
+	std::vector<Job> collected;
+	bool             running;
+
+	GenerationStats stats;
+	double          total_latency_ms;
+	double          total_load_ms;
+	double          total_generate_ms;
+
+	void
+	worker_loop();
+
+public:
+	void
+	init( ChunkManager*, ChunkPool*, HeightmapCache*, WorldStorage* );
+
+	void
+	shutdown();
+
+	bool
+	can_request() const
+	{
+		return stats.in_flight < MAX_GENERATION_JOBS;
+	}
+
+	// column is PENDING already, so lookups skip it while workers fill it
+	void
+	request( ChunkColumn* column );
+
+	// appends columns finished since last call
+	void
+	collect( std::vector<ChunkColumn*>& ready );
+
+	const GenerationStats&
+	get_stats() const
+	{
+		return stats;
+	}
+};
@@ -0,0 +1,116 @@
+#include "column_table.hpp"
+
+ColumnTable::ColumnTable()
+    : mask( 0 )
+    , count( 0 )
+{
+	rehash( MIN_CAPACITY );
+}
+
+size_t
+ColumnTable::hash( const glm::ivec2& key )
+{
+	// column coordinates are small signed numbers, pack both axes and mix
+	// so neighbouring columns do not form long probe runs
+	uint64_t h = uint64_t( uint32_t( key.x ) ) |
+	             ( uint64_t( uint32_t( key.y ) ) << 32 );
+
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ull;
+	h ^= h >> 33;
+
+	return size_t( h );
+}
+
+size_t
+ColumnTable::find_slot( const glm::ivec2& key ) const
+{
+	size_t idx = hash( key ) & mask;
+
+	while ( slots[ idx ].column != nullptr && slots[ idx ].key != key )
+	{
+		idx = ( idx + 1 ) & mask;
+	}
+
+	return idx;
+}
+
+void
+ColumnTable::insert( const glm::ivec2& key, ChunkColumn* column )
+{
+	// keep load factor under 1/2, probes stay within a cache line or two
+	if ( ( count + 1 ) * 2 > slots.size() )
+	{
+		rehash( slots.size() * 2 );
+	}
+
+	size_t idx          = find_slot( key );
+	slots[ idx ].key    = key;
+	slots[ idx ].column = column;
+	count++;
+}
+
+ChunkColumn*
+ColumnTable::erase( const glm::ivec2& key )
+{
+	size_t       idx    = find_slot( key );
+	ChunkColumn* column = slots[ idx ].column;
+
+	if ( column != nullptr )
+	{
+		erase_slot( idx );
+	}
+
+	return column;
+}
+
+void
+ColumnTable::erase_slot( size_t idx )
+{
+	size_t next = idx;
+
+	for ( ;; )
+	{
+		next = ( next + 1 ) & mask;
+
+		if ( slots[ next ].column == nullptr )
+		{
+			break;
+		}
+
+		size_t home = hash( slots[ next ].key ) & mask;
+
+		// entry may fill the hole only if hole lies between its home slot
+		// and its current slot
+		if ( ( ( next - home ) & mask ) >= ( ( next - idx ) & mask ) )
+		{
+			slots[ idx ] = slots[ next ];
+			idx          = next;
+		}
+	}
+
+	slots[ idx ].column = nullptr;
+	count--;
+}
+
+void
+ColumnTable::rehash( size_t capacity )
+{
+	std::vector<Slot> old_slots( capacity, Slot { glm::ivec2( 0 ), nullptr } );
+	old_slots.swap( slots );
+	mask  = capacity - 1;
+	count = 0;
+
+	for ( const Slot& slot : old_slots )
+	{
+		if ( slot.column != nullptr )
+		{
+			size_t idx          = find_slot( slot.key );
+			slots[ idx ].key    = slot.key;
+			slots[ idx ].column = slot.column;
+			count++;
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct ChunkColumn;
+
+// open addressing with linear probing, columns are owned by caller so
+// pointers stay valid across rehashes. erase uses backward shift instead of
+// tombstones so the table never needs cleanup after eviction sweeps
+class ColumnTable
+{
+private:
+	static constexpr size_t MIN_CAPACITY = 1024;
+
+	struct Slot
+	{
+		glm::ivec2   key;
+		ChunkColumn* column;
+	};
+
+	std::vector<Slot> slots;
+	size_t            mask;
+	size_t            count;
+
+	static size_t
+	hash( const glm::ivec2& key );
+
+	size_t
+	find_slot( const glm::ivec2& key ) const;
+
+	void
+	erase_slot( size_t idx );
+
+	void
+	rehash( size_t capacity );
+
+public:
+	ColumnTable();
+
+	ChunkColumn*
+	find( const glm::ivec2& key ) const
+	{
+		size_t idx = find_slot( key );
+		return slots[ idx ].column;
+	}
+
+	// key must not be present
+	void
+	insert( const glm::ivec2& key, ChunkColumn* column );
+
+	// returns removed column or nullptr
+	ChunkColumn*
+	erase( const glm::ivec2& key );
+
+	// fn( ChunkColumn* ) returns true when column must be removed, caller
+	// takes ownership of removed column inside fn
+	template <typename Fn>
+	void
+	erase_if( Fn&& fn )
+	{
+		// scan starts after an empty slot. backward shift never moves an
+		// entry across one, so visited entries cannot wrap around into
+		// the scanned range again
+		size_t start = 0;
+
+		while ( slots[ start ].column != nullptr )
+		{
+			start++;
+		}
+
+		for ( size_t n = 1; n <= slots.size(); n++ )
+		{
+			size_t i = ( start + n ) & mask;
+
+			// backward shift may move unvisited entry into i, so check again
+			while ( slots[ i ].column != nullptr && fn( slots[ i ].column ) )
+			{
+				erase_slot( i );
+			}
+		}
+	}
+
+	template <typename Fn>
+	void
+	for_each( Fn&& fn ) const
+	{
+		for ( const Slot& slot : slots )
+		{
+			if ( slot.column != nullptr )
+			{
+				fn( slot.column );
+			}
+		}
+	}
+
+	size_t
+	size() const
+	{
+		return count;
+	}
+
+	size_t
+	capacity() const
+	{
+		return slots.size();
+	}
+};
@@ -7,9 +7,64 @@ static constexpr int32_t CHUNK_SIZE         = 16;
 static constexpr int32_t CHUNK_SIZE_SQUARED = CHUNK_SIZE * CHUNK_SIZE;
 static constexpr int32_t CHUNK_SIZE_CUBED   = CHUNK_SIZE_SQUARED * CHUNK_SIZE;
 
+// world
+static constexpr int32_t WORLD_HEIGHT           = 256;
+static constexpr int32_t WORLD_HEIGHT_IN_CHUNKS = WORLD_HEIGHT / CHUNK_SIZE;
+// everything below is stone, terrain relief starts here
+static constexpr int32_t TERRAIN_BASE_HEIGHT = 64;
+// bump whenever generated voxels change, edit overlays saved against
+// another terrain version are dropped instead of replayed onto it
+static constexpr uint8_t TERRAIN_VERSION = 4;
+// region files of edited columns
+static constexpr const char* WORLD_DIRECTORY = "world";
+
 // chunk manager
 static constexpr int32_t RENDER_DISTANCE           = 14 * CHUNK_SIZE;
 static constexpr int32_t CHUNKS_IN_RENDER_DISTANCE = 14;
+// columns are loaded inside render distance but kept until they leave
+// unload distance, walking along the border does not reload them
+static constexpr int32_t CHUNKS_UNLOAD_DISTANCE = CHUNKS_IN_RENDER_DISTANCE + 3;
+// columns between render and unload distance are dropped early above this
+static constexpr uint64_t VOXEL_MEMORY_BUDGET = 64 * 1024 * 1024;
+// least recently used columns checked for eviction per frame
+static constexpr int32_t COLUMN_EVICTIONS_PER_FRAME = 16;
+// missing columns handed to generation per frame, best first
+static constexpr int32_t COLUMN_REQUESTS_PER_FRAME = 16;
+// column straight behind camera waits as if it were ( 1 + 2 * weight )
+// times farther away than same column in front of it
+static constexpr float VIEW_PRIORITY_WEIGHT = 3.0f;
+// columns within this angle cosine of camera direction count as in front
+static constexpr float VIEW_CONE_COS = 0.5f;
+
+// far terrain, level L meshes 2^L x 2^L x 2^L voxels as one and reaches
+// LOD_TILE_RADIUS tiles of 2^L x 2^L columns from camera, so levels 1-3
+// see 16, 32 and 64 chunks far
+static constexpr int32_t LOD_LEVELS          = 3;
+static constexpr int32_t LOD_TILE_RADIUS     = 8;
+static constexpr int32_t LOD_TILES_PER_FRAME = 8;
+
+// light, levels 0 to MAX_LIGHT fit a nibble
+static constexpr uint8_t MAX_LIGHT = 15;
+
+// rays a raycast worker takes from a batch at once, batches up to this
+// many are cast on calling thread
+static constexpr int32_t RAYCAST_RAYS_PER_THREAD = 256;
+
+// mesh cache, meshes not drawn last frame are dropped above budget
+static constexpr uint64_t MESH_MEMORY_BUDGET       = 128 * 1024 * 1024;
+static constexpr int32_t  MESH_EVICTIONS_PER_FRAME = 64;
+
+// chunk pool, visible columns are ~5 sections tall plus some room for
+// chunks waiting for eviction
+static constexpr int32_t CHUNK_POOL_RESERVE       = 4096;
+static constexpr int32_t CHUNK_RELEASES_PER_FRAME = 64;
+
+// generation, same seed generates same world
+static constexpr uint32_t WORLD_SEED = 0x5eed;
+// columns requested but not handed back to render thread
+static constexpr int32_t MAX_GENERATION_JOBS = 64;
+// heightmaps kept after their columns unload, 1.25 KiB each
+static constexpr int32_t HEIGHTMAP_CACHE_CAPACITY = 4096;
 
 // uv
 static constexpr int32_t SPRITES_IN_SIDE = 16;
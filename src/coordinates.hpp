@@ -1,9 +1,18 @@
 #pragma once
 
+#include <array>
 #include <fluent/os.h>
 #include <glm/glm.hpp>
 #include "constants.hpp"
 
+// gcc and clang define __BMI2__ only with -mbmi2, avx2 alone does not
+// imply it. msvc has no such macro and enables pdep with /arch:AVX2
+#if defined( VK_CRAFT_MORTON_LAYOUT ) &&                                       \
+    ( defined( __BMI2__ ) || ( defined( _MSC_VER ) && defined( __AVX2__ ) ) )
+#include <immintrin.h>
+#define VK_CRAFT_USE_PDEP
+#endif
+
 static inline void
 to_voxel_position( glm::ivec3& r, const glm::vec3 position )
 {
@@ -45,3 +54,40 @@ local_voxel_to_global( glm::ivec3&      r,
 	r[ 1 ] = chunk_pos[ 1 ] * CHUNK_SIZE + voxel_pos[ 1 ];
 	r[ 2 ] = chunk_pos[ 2 ] * CHUNK_SIZE + voxel_pos[ 2 ];
 }
+
+#if defined( VK_CRAFT_MORTON_LAYOUT )
+
+static_assert( CHUNK_SIZE == 16, "morton layout expects 4 bit coordinates" );
+
+// bit i of v goes to bit 3 * i
+static constexpr std::array<uint16_t, CHUNK_SIZE> MORTON_SPREAD = {
+    0x000, 0x001, 0x008, 0x009, 0x040, 0x041, 0x048, 0x049,
+    0x200, 0x201, 0x208, 0x209, 0x240, 0x241, 0x248, 0x249,
+};
+
+// z-order, x in lowest bits then z then y, so 2x2x2 neighbourhoods share
+// a cache line whatever axis mesher or raycast walks along
+static inline uint32_t
+local_voxel_to_index( const glm::ivec3 position )
+{
+#if defined( VK_CRAFT_USE_PDEP )
+	return _pdep_u32( position[ 0 ], 0x249 ) |
+	       _pdep_u32( position[ 2 ], 0x492 ) |
+	       _pdep_u32( position[ 1 ], 0x924 );
+#else
+	return MORTON_SPREAD[ position[ 0 ] ] |
+	       ( MORTON_SPREAD[ position[ 2 ] ] << 1 ) |
+	       ( MORTON_SPREAD[ position[ 1 ] ] << 2 );
+#endif
+}
+
+#else
+
+static inline uint32_t
+local_voxel_to_index( const glm::ivec3 position )
+{
+	return position[ 0 ] + CHUNK_SIZE_SQUARED * position[ 1 ] +
+	       CHUNK_SIZE * position[ 2 ];
+}
+
+#endif
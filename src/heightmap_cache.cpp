@@ -0,0 +1,84 @@
+#include "heightmap_cache.hpp"
+
+void
+HeightmapCache::init( size_t capacity )
+{
+	this->capacity = capacity;
+	stats          = {};
+	lookup.reserve( capacity );
+}
+
+void
+HeightmapCache::shutdown()
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	entries.clear();
+	lookup.clear();
+	stats = {};
+}
+
+void
+HeightmapCache::get( const glm::ivec2 position, Heightmap& heights )
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+
+		auto it = lookup.find( position );
+
+		if ( it != lookup.end() )
+		{
+			entries.splice( entries.begin(), entries, it->second );
+			heights = it->second->heights;
+			stats.hits++;
+			return;
+		}
+
+		stats.misses++;
+	}
+
+	// noise is evaluated without the lock, other workers keep hitting
+	generate_heightmap( heights, position );
+
+	std::lock_guard<std::mutex> lock( mutex );
+	insert( position, heights );
+}
+
+void
+HeightmapCache::insert( const glm::ivec2 position, const Heightmap& heights )
+{
+	// another worker may have generated same column meanwhile
+	if ( lookup.find( position ) != lookup.end() )
+	{
+		return;
+	}
+
+	if ( entries.size() < capacity )
+	{
+		entries.emplace_front();
+	}
+	else
+	{
+		// reuse least recently used node instead of allocating
+		lookup.erase( entries.back().position );
+		entries.splice( entries.begin(), entries, std::prev( entries.end() ) );
+	}
+
+	Entry& entry       = entries.front();
+	entry.position     = position;
+	entry.heights      = heights;
+	lookup[ position ] = entries.begin();
+
+	// list node has two links, map node one link and a bucket slot
+	size_t entry_bytes = sizeof( Entry ) + 2 * sizeof( void* ) +
+	                     sizeof( std::pair<glm::ivec2, Entries::iterator> ) +
+	                     2 * sizeof( void* );
+	stats.entries = entries.size();
+	stats.bytes   = entries.size() * entry_bytes;
+}
+
+HeightmapCacheStats
+HeightmapCache::get_stats() const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	return stats;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <glm/gtx/hash.hpp>
+#include "chunk.hpp"
+
+struct HeightmapCacheStats
+{
+	size_t hits;
+	size_t misses;
+	size_t entries;
+	// heightmaps plus list and map bookkeeping
+	size_t bytes;
+};
+
+// generated heightmaps by column position, least recently used one is
+// dropped when full. shared by generation workers, noise for a column is
+// evaluated again only after it falls out of cache
+class HeightmapCache
+{
+private:
+	struct Entry
+	{
+		glm::ivec2 position;
+		Heightmap  heights;
+	};
+
+	using Entries = std::list<Entry>;
+
+	mutable std::mutex mutex;
+	size_t             capacity;
+	// most recently used first
+	Entries                                           entries;
+	std::unordered_map<glm::ivec2, Entries::iterator> lookup;
+	HeightmapCacheStats                               stats;
+
+	void
+	insert( const glm::ivec2 position, const Heightmap& heights );
+
+public:
+	void
+	init( size_t capacity );
+
+	void
+	shutdown();
+
+	// copies cached heightmap or generates and caches it
+	void
+	get( const glm::ivec2 position, Heightmap& heights );
+
+	HeightmapCacheStats
+	get_stats() const;
+};
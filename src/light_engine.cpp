@@ -0,0 +1,620 @@
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+#include "chunk_pool.hpp"
+#include "chunk_column.hpp"
+#include "column_table.hpp"
+#include "light_engine.hpp"
+
+static const glm::ivec3 NEIGHBOR_OFFSETS[ 6 ] = {
+    { 0, 0, 1 },
+    { 0, 0, -1 },
+    { -1, 0, 0 },
+    { 1, 0, 0 },
+    { 0, -1, 0 },
+    { 0, 1, 0 },
+};
+
+static inline int32_t
+floor_div( int32_t a, int32_t b )
+{
+	return a / b - ( a % b < 0 );
+}
+
+static inline uint8_t
+get_channel( Light light, LightEngine::Channel channel )
+{
+	return channel == LightEngine::SKY ? get_sky_light( light )
+	                                   : get_block_light( light );
+}
+
+// what voxel gives to its neighbors, opaque ones hold nothing but what
+// they emit
+static inline uint8_t
+get_level( Voxel::Type voxel, Light light, LightEngine::Channel channel )
+{
+	if ( channel == LightEngine::SKY )
+	{
+		return is_opaque( voxel ) ? 0 : get_sky_light( light );
+	}
+
+	uint8_t emission = get_light_emission( voxel );
+
+	return is_opaque( voxel ) ? emission
+	                          : std::max( get_block_light( light ), emission );
+}
+
+void
+LightEngine::init( ChunkManager*      chunk_manager,
+                   ChunkPool*         chunk_pool,
+                   const ColumnTable* columns )
+{
+	this->chunk_manager    = chunk_manager;
+	this->chunk_pool       = chunk_pool;
+	this->columns          = columns;
+	single_column          = nullptr;
+	cached_column          = nullptr;
+	changes.bytes          = 0;
+	changes.sections_added = false;
+	pending_updates        = 0;
+	relit_voxels           = 0;
+	stats                  = {};
+}
+
+ChunkColumn*
+LightEngine::find_column( const glm::ivec2& position )
+{
+	if ( columns == nullptr )
+	{
+		return single_column->position == position ? single_column : nullptr;
+	}
+
+	ChunkColumn* column = columns->find( position );
+
+	// pending columns belong to generation workers
+	if ( column == nullptr || column->state == ChunkColumn::PENDING )
+	{
+		return nullptr;
+	}
+
+	return column;
+}
+
+bool
+LightEngine::find( const glm::ivec3& position, Cell& cell )
+{
+	if ( position.y < 0 || position.y >= WORLD_HEIGHT )
+	{
+		return false;
+	}
+
+	glm::ivec2 column_position( floor_div( position.x, CHUNK_SIZE ),
+	                            floor_div( position.z, CHUNK_SIZE ) );
+
+	if ( cached_column == nullptr || column_position != cached_position )
+	{
+		cached_position = column_position;
+		cached_column   = find_column( column_position );
+
+		if ( cached_column == nullptr )
+		{
+			return false;
+		}
+	}
+
+	cell.column  = cached_column;
+	cell.section = position.y / CHUNK_SIZE;
+	cell.chunk   = cached_column->sections[ cell.section ];
+	cell.local   = glm::ivec3( position.x - column_position.x * CHUNK_SIZE,
+	                           position.y % CHUNK_SIZE,
+	                           position.z - column_position.y * CHUNK_SIZE );
+
+	if ( cell.chunk == nullptr )
+	{
+		cell.voxel = Voxel::AIR;
+		cell.light = OPEN_SKY_LIGHT;
+	}
+	else
+	{
+		cell.voxel = cell.chunk->get_voxel( cell.local );
+		cell.light = cell.chunk->get_light( cell.local );
+	}
+
+	return true;
+}
+
+void
+LightEngine::store( Cell& cell, Light value )
+{
+	if ( value == cell.light )
+	{
+		return;
+	}
+
+	glm::ivec3 chunk_position( cell.column->position.x,
+	                           cell.section,
+	                           cell.column->position.y );
+	size_t     old_bytes = 0;
+
+	if ( cell.chunk == nullptr )
+	{
+		// unallocated sections hold OPEN_SKY_LIGHT, anything else needs one
+		cell.chunk = chunk_pool->acquire();
+		cell.chunk->attach( chunk_position, chunk_manager, cell.column );
+		cell.column->sections[ cell.section ] = cell.chunk;
+		changes.sections_added                = true;
+	}
+	else
+	{
+		old_bytes = cell.chunk->memory_usage();
+	}
+
+	cell.chunk->set_light( cell.local, value );
+	cell.light = value;
+	relit_voxels++;
+
+	// generation workers leave counting to collect, and whole column is
+	// meshed anyway once it is visible
+	if ( columns == nullptr )
+	{
+		return;
+	}
+
+	size_t new_bytes = cell.chunk->memory_usage();
+	cell.column->memory_bytes += new_bytes - old_bytes;
+	changes.bytes += new_bytes - old_bytes;
+
+	if ( changes.chunks.empty() || changes.chunks.back() != chunk_position )
+	{
+		changes.chunks.push_back( chunk_position );
+	}
+
+	// faces of neighbor chunk touching this voxel are lit by it, light is
+	// only read in front of a face so edge and corner chunks never are
+	for ( int32_t axis = 0; axis < 3; axis++ )
+	{
+		glm::ivec3 offset( 0 );
+		offset[ axis ] = 1;
+
+		if ( cell.local[ axis ] == 0 )
+		{
+			changes.chunks.push_back( chunk_position - offset );
+		}
+		if ( cell.local[ axis ] == CHUNK_SIZE - 1 )
+		{
+			changes.chunks.push_back( chunk_position + offset );
+		}
+	}
+}
+
+void
+LightEngine::set_level( Cell& cell, Channel channel, uint8_t level )
+{
+	Light value = channel == SKY
+	                  ? Light( ( level << 4 ) | ( cell.light & 0xF ) )
+	                  : Light( ( cell.light & 0xF0 ) | level );
+	store( cell, value );
+}
+
+void
+LightEngine::unspread( Channel channel )
+{
+	std::deque<Removal>&    queue   = remove_queues[ channel ];
+	std::deque<glm::ivec3>& refills = add_queues[ channel ];
+
+	while ( !queue.empty() )
+	{
+		Removal removal = queue.front();
+		queue.pop_front();
+
+		for ( const glm::ivec3& offset : NEIGHBOR_OFFSETS )
+		{
+			glm::ivec3 position = removal.position + offset;
+			Cell       neighbor;
+
+			if ( !find( position, neighbor ) )
+			{
+				continue;
+			}
+
+			if ( is_opaque( neighbor.voxel ) )
+			{
+				// emitter may have lit what was just cleared
+				if ( channel == BLOCK &&
+				     get_light_emission( neighbor.voxel ) > 0 )
+				{
+					refills.push_back( position );
+				}
+				continue;
+			}
+
+			uint8_t level = get_channel( neighbor.light, channel );
+
+			if ( level == 0 )
+			{
+				continue;
+			}
+
+			// full sunlight below full sunlight fell through removed voxel
+			bool fed = level < removal.level ||
+			           ( channel == SKY && offset.y < 0 &&
+			             removal.level == MAX_LIGHT );
+
+			if ( fed )
+			{
+				set_level( neighbor, channel, 0 );
+				queue.push_back( { position, level } );
+			}
+			else
+			{
+				// lit from elsewhere, spreads back into cleared voxels
+				refills.push_back( position );
+			}
+		}
+	}
+}
+
+void
+LightEngine::spread( Channel channel )
+{
+	std::deque<glm::ivec3>& queue = add_queues[ channel ];
+
+	while ( !queue.empty() )
+	{
+		glm::ivec3 position = queue.front();
+		queue.pop_front();
+
+		Cell cell;
+
+		if ( !find( position, cell ) )
+		{
+			continue;
+		}
+
+		uint8_t level = get_level( cell.voxel, cell.light, channel );
+
+		if ( level <= 1 )
+		{
+			continue;
+		}
+
+		for ( const glm::ivec3& offset : NEIGHBOR_OFFSETS )
+		{
+			glm::ivec3 neighbor_position = position + offset;
+			Cell       neighbor;
+
+			if ( !find( neighbor_position, neighbor ) ||
+			     is_opaque( neighbor.voxel ) )
+			{
+				continue;
+			}
+
+			// sunlight falls without losing anything
+			uint8_t next =
+			    channel == SKY && offset.y < 0 && level == MAX_LIGHT
+			        ? MAX_LIGHT
+			        : level - 1;
+
+			if ( get_channel( neighbor.light, channel ) >= next )
+			{
+				continue;
+			}
+
+			set_level( neighbor, channel, next );
+			queue.push_back( neighbor_position );
+		}
+	}
+}
+
+void
+LightEngine::light_column( ChunkColumn& column )
+{
+	single_column = &column;
+	cached_column = nullptr;
+
+	glm::ivec3 origin( column.position.x * CHUNK_SIZE,
+	                   0,
+	                   column.position.y * CHUNK_SIZE );
+
+	// sunlight falls straight down to first opaque voxel, everything below
+	// it starts dark and is lit from the side afterwards
+	for ( int32_t z = 0; z < CHUNK_SIZE; z++ )
+	{
+		for ( int32_t x = 0; x < CHUNK_SIZE; x++ )
+		{
+			bool open = true;
+
+			sky_floors[ x + CHUNK_SIZE * z ] = 0;
+
+			for ( int32_t y = WORLD_HEIGHT - 1; y >= 0; y-- )
+			{
+				const Chunk* chunk = column.sections[ y / CHUNK_SIZE ];
+
+				// open sky through whole unallocated section
+				if ( chunk == nullptr && open )
+				{
+					y -= CHUNK_SIZE - 1;
+					continue;
+				}
+
+				glm::ivec3  position = origin + glm::ivec3( x, y, z );
+				Voxel::Type voxel =
+				    chunk != nullptr
+				        ? chunk->get_voxel( { x, y % CHUNK_SIZE, z } )
+				        : Voxel::AIR;
+
+				if ( is_opaque( voxel ) )
+				{
+					if ( open )
+					{
+						sky_floors[ x + CHUNK_SIZE * z ] = y + 1;
+					}
+
+					open = false;
+
+					if ( get_light_emission( voxel ) > 0 )
+					{
+						add_queues[ BLOCK ].push_back( position );
+					}
+				}
+				else if ( !open )
+				{
+					Cell cell;
+					find( position, cell );
+					store( cell, 0 );
+					dark_voxels.push_back( position );
+				}
+			}
+		}
+	}
+
+	// sunlit voxels next to dark ones light them. voxels above and below a
+	// dark one are never sunlit and other columns are not visible here, so
+	// only side neighbors standing above their sky floor are looked up
+	for ( const glm::ivec3& position : dark_voxels )
+	{
+		glm::ivec3 local = position - origin;
+
+		for ( const glm::ivec3& offset : NEIGHBOR_OFFSETS )
+		{
+			glm::ivec3 side = local + offset;
+			Cell       neighbor;
+
+			if ( offset.y != 0 || side.x < 0 || side.x >= CHUNK_SIZE ||
+			     side.z < 0 || side.z >= CHUNK_SIZE ||
+			     position.y < sky_floors[ side.x + CHUNK_SIZE * side.z ] )
+			{
+				continue;
+			}
+
+			if ( find( position + offset, neighbor ) &&
+			     get_level( neighbor.voxel, neighbor.light, SKY ) > 1 )
+			{
+				add_queues[ SKY ].push_back( position + offset );
+			}
+		}
+	}
+
+	dark_voxels.clear();
+
+	for ( uint32_t channel = 0; channel < CHANNEL_COUNT; channel++ )
+	{
+		spread( Channel( channel ) );
+	}
+
+	single_column = nullptr;
+	cached_column = nullptr;
+}
+
+void
+LightEngine::join_column( ChunkColumn& column )
+{
+	cached_column = nullptr;
+
+	static const glm::ivec2 offsets[ 4 ] = {
+	    { -1, 0 },
+	    { 1, 0 },
+	    { 0, -1 },
+	    { 0, 1 },
+	};
+
+	for ( const glm::ivec2& offset : offsets )
+	{
+		ChunkColumn* neighbor = find_column( column.position + offset );
+
+		if ( neighbor == nullptr )
+		{
+			continue;
+		}
+
+		int32_t axis = offset.x != 0 ? 0 : 2;
+		int32_t side = axis == 0 ? 2 : 0;
+
+		// border plane of column and plane of neighbor touching it
+		glm::ivec3 inner( 0 ), outer( 0 );
+		inner[ axis ] = offset[ axis / 2 ] < 0 ? 0 : CHUNK_SIZE - 1;
+		outer[ axis ] = CHUNK_SIZE - 1 - inner[ axis ];
+
+		glm::ivec3 origin( column.position.x * CHUNK_SIZE,
+		                   0,
+		                   column.position.y * CHUNK_SIZE );
+		glm::ivec3 neighbor_origin( neighbor->position.x * CHUNK_SIZE,
+		                            0,
+		                            neighbor->position.y * CHUNK_SIZE );
+
+		for ( int32_t section = 0; section < WORLD_HEIGHT_IN_CHUNKS;
+		      section++ )
+		{
+			const Chunk* a = column.sections[ section ];
+			const Chunk* b = neighbor->sections[ section ];
+
+			// both sides under open sky, nothing to cross
+			if ( ( a == nullptr || a->shaded_voxels == 0 ) &&
+			     ( b == nullptr || b->shaded_voxels == 0 ) )
+			{
+				continue;
+			}
+
+			for ( int32_t y = 0; y < CHUNK_SIZE; y++ )
+			{
+				for ( int32_t i = 0; i < CHUNK_SIZE; i++ )
+				{
+					inner.y = outer.y = y;
+					inner[ side ] = outer[ side ] = i;
+
+					Voxel::Type a_voxel =
+					    a != nullptr ? a->get_voxel( inner ) : Voxel::AIR;
+					Voxel::Type b_voxel =
+					    b != nullptr ? b->get_voxel( outer ) : Voxel::AIR;
+					Light a_light =
+					    a != nullptr ? a->get_light( inner ) : OPEN_SKY_LIGHT;
+					Light b_light =
+					    b != nullptr ? b->get_light( outer ) : OPEN_SKY_LIGHT;
+
+					glm::ivec3 a_position = origin + inner;
+					glm::ivec3 b_position = neighbor_origin + outer;
+					a_position.y = b_position.y = section * CHUNK_SIZE + y;
+
+					for ( uint32_t c = 0; c < CHANNEL_COUNT; c++ )
+					{
+						Channel channel = Channel( c );
+						uint8_t a_level =
+						    get_level( a_voxel, a_light, channel );
+						uint8_t b_level =
+						    get_level( b_voxel, b_light, channel );
+
+						if ( a_level > b_level + 1 && !is_opaque( b_voxel ) )
+						{
+							add_queues[ channel ].push_back( a_position );
+						}
+						else if ( b_level > a_level + 1 &&
+						          !is_opaque( a_voxel ) )
+						{
+							add_queues[ channel ].push_back( b_position );
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void
+LightEngine::update_voxel( const glm::ivec3& position,
+                           Voxel::Type       old_voxel,
+                           Voxel::Type       voxel )
+{
+	if ( is_opaque( old_voxel ) == is_opaque( voxel ) &&
+	     get_light_emission( old_voxel ) == get_light_emission( voxel ) )
+	{
+		return;
+	}
+
+	cached_column = nullptr;
+
+	Cell cell;
+
+	if ( !find( position, cell ) )
+	{
+		return;
+	}
+
+	pending_updates++;
+
+	for ( uint32_t c = 0; c < CHANNEL_COUNT; c++ )
+	{
+		Channel channel   = Channel( c );
+		uint8_t old_level = get_level( old_voxel, cell.light, channel );
+
+		if ( old_level > 0 )
+		{
+			remove_queues[ channel ].push_back( { position, old_level } );
+		}
+	}
+
+	if ( is_opaque( voxel ) )
+	{
+		resets.push_back( { position, OPEN_SKY_LIGHT } );
+
+		if ( get_light_emission( voxel ) > 0 )
+		{
+			add_queues[ BLOCK ].push_back( position );
+		}
+
+		return;
+	}
+
+	// neighbors fill it again, top of the world is open to the sky
+	if ( position.y == WORLD_HEIGHT - 1 )
+	{
+		resets.push_back( { position, OPEN_SKY_LIGHT } );
+		add_queues[ SKY ].push_back( position );
+	}
+	else
+	{
+		resets.push_back( { position, 0 } );
+	}
+
+	for ( const glm::ivec3& offset : NEIGHBOR_OFFSETS )
+	{
+		for ( std::deque<glm::ivec3>& queue : add_queues )
+		{
+			queue.push_back( position + offset );
+		}
+	}
+}
+
+void
+LightEngine::propagate()
+{
+	using Clock = std::chrono::steady_clock;
+
+	Clock::time_point start = Clock::now();
+	cached_column           = nullptr;
+
+	for ( const Reset& reset : resets )
+	{
+		Cell cell;
+
+		if ( find( reset.position, cell ) )
+		{
+			store( cell, reset.light );
+		}
+	}
+
+	resets.clear();
+
+	for ( uint32_t channel = 0; channel < CHANNEL_COUNT; channel++ )
+	{
+		unspread( Channel( channel ) );
+		spread( Channel( channel ) );
+	}
+
+	auto less = []( const glm::ivec3& a, const glm::ivec3& b )
+	{ return std::tie( a.x, a.y, a.z ) < std::tie( b.x, b.y, b.z ); };
+
+	std::sort( changes.chunks.begin(), changes.chunks.end(), less );
+	changes.chunks.erase(
+	    std::unique( changes.chunks.begin(), changes.chunks.end() ),
+	    changes.chunks.end() );
+
+	// joining columns is part of streaming, only edits are measured
+	if ( pending_updates == 0 )
+	{
+		relit_voxels = 0;
+		return;
+	}
+
+	double ms =
+	    std::chrono::duration<double, std::milli>( Clock::now() - start )
+	        .count();
+
+	stats.updates += pending_updates;
+	stats.relit_voxels += relit_voxels;
+	stats.relights++;
+	stats.last_relight_ms = ms;
+	stats.average_relight_ms +=
+	    ( ms - stats.average_relight_ms ) / double( stats.relights );
+	pending_updates = 0;
+	relit_voxels    = 0;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <deque>
+#include <vector>
+#include <glm/glm.hpp>
+#include "constants.hpp"
+#include "voxel.hpp"
+
+class ChunkManager;
+class ChunkPool;
+class ColumnTable;
+struct Chunk;
+struct ChunkColumn;
+
+struct LightStats
+{
+	// voxel edits which could change light
+	size_t updates;
+	// light rewritten because of edits, streaming columns in is not counted
+	size_t relit_voxels;
+	// propagations after edits, one per bulk edit
+	size_t relights;
+	double last_relight_ms;
+	double average_relight_ms;
+};
+
+// flood fill of sky and block light through loaded columns. sky light
+// keeps its level going straight down, every other step costs one level.
+// removals and additions are queued and run breadth first, so an edit
+// rewrites only voxels whose light actually changes. columns which are not
+// generated yet are dark walls, light crosses into them once they join
+class LightEngine
+{
+public:
+	enum Channel : uint32_t
+	{
+		SKY,
+		BLOCK,
+		CHANNEL_COUNT
+	};
+
+	// what propagation did besides writing light, caller resets it
+	struct Changes
+	{
+		// chunks whose meshes depend on rewritten light, sorted
+		std::vector<glm::ivec3> chunks;
+		// sections and light arrays allocated to hold light
+		size_t bytes;
+		bool   sections_added;
+	};
+
+private:
+	struct Removal
+	{
+		glm::ivec3 position;
+		uint8_t    level;
+	};
+
+	struct Reset
+	{
+		glm::ivec3 position;
+		Light      light;
+	};
+
+	// voxel resolved to its column, chunk is nullptr for unallocated section
+	struct Cell
+	{
+		ChunkColumn* column;
+		Chunk*       chunk;
+		int32_t      section;
+		glm::ivec3   local;
+		Voxel::Type  voxel;
+		Light        light;
+	};
+
+	ChunkManager* chunk_manager;
+	ChunkPool*    chunk_pool;
+	// nullptr on generation workers, they see only the column they light
+	const ColumnTable* columns;
+	ChunkColumn*       single_column;
+	// last column looked up, neighbors are mostly in the same one
+	glm::ivec2   cached_position;
+	ChunkColumn* cached_column;
+
+	std::array<std::deque<glm::ivec3>, CHANNEL_COUNT> add_queues;
+	std::array<std::deque<Removal>, CHANNEL_COUNT>    remove_queues;
+	// light of edited voxels, written by propagate so chunk manager can
+	// count voxel memory of an edit apart from light memory
+	std::vector<Reset> resets;
+	// scratch of light_column, lowest sunlit height of every ( x, z )
+	std::vector<glm::ivec3>                 dark_voxels;
+	std::array<int32_t, CHUNK_SIZE_SQUARED> sky_floors;
+
+	Changes    changes;
+	size_t     pending_updates;
+	size_t     relit_voxels;
+	LightStats stats;
+
+	ChunkColumn*
+	find_column( const glm::ivec2& position );
+
+	// false outside of world height and generated columns
+	bool
+	find( const glm::ivec3& position, Cell& cell );
+
+	void
+	store( Cell& cell, Light value );
+
+	void
+	set_level( Cell& cell, Channel channel, uint8_t level );
+
+	// clears light fed by queued removals, queues what may fill it again
+	void
+	unspread( Channel channel );
+
+	void
+	spread( Channel channel );
+
+public:
+	void
+	init( ChunkManager*, ChunkPool*, const ColumnTable* );
+
+	// lights column owned by a generation worker as if it stood alone
+	void
+	light_column( ChunkColumn& column );
+
+	// queues light crossing between just generated column and its loaded
+	// neighbors
+	void
+	join_column( ChunkColumn& column );
+
+	// voxel at position was changed from old_voxel, call after the write
+	void
+	update_voxel( const glm::ivec3& position,
+	              Voxel::Type       old_voxel,
+	              Voxel::Type       voxel );
+
+	// runs queued removals then additions
+	void
+	propagate();
+
+	Changes&
+	get_changes()
+	{
+		return changes;
+	}
+
+	const LightStats&
+	get_stats() const
+	{
+		return stats;
+	}
+};
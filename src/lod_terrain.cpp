@@ -0,0 +1,325 @@
+#include <algorithm>
+#include "mesh_generator.hpp"
+#include "lod_terrain.hpp"
+
+static_assert( 2 * LOD_TILE_RADIUS >= CHUNKS_IN_RENDER_DISTANCE + 1,
+               "first lod level must surround render distance" );
+static_assert( LOD_TILE_RADIUS >= 4, "lod level must surround finer one" );
+static_assert( ( CHUNK_SIZE >> LOD_LEVELS ) >= 1,
+               "lod cell must not be wider than column" );
+
+static inline int32_t
+floor_div( int32_t a, int32_t b )
+{
+	return a / b - ( a % b < 0 );
+}
+
+void
+LodTerrain::init()
+{
+	center       = glm::ivec2( 0, 0 );
+	center_valid = false;
+	pending      = false;
+	update_count = 0;
+	stats        = {};
+}
+
+void
+LodTerrain::shutdown()
+{
+	tiles.clear();
+	visible_tiles.clear();
+}
+
+LodTerrain::Rect
+LodTerrain::inner_rect( int32_t level ) const
+{
+	if ( level == 1 )
+	{
+		return { center - CHUNKS_IN_RENDER_DISTANCE,
+		         center + CHUNKS_IN_RENDER_DISTANCE };
+	}
+
+	int32_t    scale = 1 << ( level - 1 );
+	glm::ivec2 middle( floor_div( center.x, scale ),
+	                   floor_div( center.y, scale ) );
+
+	return { ( middle - LOD_TILE_RADIUS ) * scale,
+	         ( middle + LOD_TILE_RADIUS ) * scale };
+}
+
+void
+LodTerrain::generate_heights( Tile&             tile,
+                              int32_t           level,
+                              const glm::ivec2& position )
+{
+	int32_t scale = 1 << level;
+	// cells along one column
+	int32_t cells = CHUNK_SIZE / scale;
+
+	for ( int32_t cz = 0; cz < scale; cz++ )
+	{
+		for ( int32_t cx = 0; cx < scale; cx++ )
+		{
+			generate_heightmap( column_heights,
+			                    position * scale + glm::ivec2( cx, cz ) );
+
+			for ( int32_t k = 0; k < cells; k++ )
+			{
+				for ( int32_t i = 0; i < cells; i++ )
+				{
+					int32_t     height = 0;
+					Biome::Type biome  = Biome::PLAINS;
+
+					for ( int32_t dz = 0; dz < scale; dz++ )
+					{
+						for ( int32_t dx = 0; dx < scale; dx++ )
+						{
+							int32_t c = i * scale + dx +
+							            CHUNK_SIZE * ( k * scale + dz );
+
+							// surface of cell is that of its highest column
+							if ( column_heights.heights[ c ] > height )
+							{
+								height = column_heights.heights[ c ];
+								biome  = column_heights.biomes[ c ];
+							}
+						}
+					}
+
+					int32_t cell =
+					    cx * cells + i + CHUNK_SIZE * ( cz * cells + k );
+					tile.heights[ cell ] = height;
+					tile.biomes[ cell ]  = biome;
+				}
+			}
+		}
+	}
+}
+
+bool
+LodTerrain::fill_snapshot( int32_t           level,
+                           const glm::ivec2& position,
+                           int32_t           y )
+{
+	int32_t scale  = 1 << level;
+	int32_t bottom = y * CHUNK_SIZE;
+
+	snapshot.position = glm::ivec3( position.x, y, position.y );
+	snapshot.scale    = scale;
+	snapshot.voxels.fill( Voxel::AIR );
+	// far terrain has no caves or lamps, all of it lies under open sky
+	snapshot.light.fill( OPEN_SKY_LIGHT );
+	snapshot.x_rows.fill( 0 );
+	snapshot.z_rows.fill( 0 );
+	snapshot.slices.fill( 0 );
+
+	for ( int32_t z = 0; z < CHUNK_SIZE; z++ )
+	{
+		for ( int32_t x = 0; x < CHUNK_SIZE; x++ )
+		{
+			int32_t     height = cell_heights[ x + CHUNK_SIZE * z ];
+			Biome::Type biome  = cell_biomes[ x + CHUNK_SIZE * z ];
+			// cells with any voxel below surface are solid
+			int32_t top = ( height + scale - 1 ) / scale - bottom;
+
+			// apron below and above comes from same tile, sides stay AIR
+			for ( int32_t cy = std::max( -1, -bottom );
+			      cy <= CHUNK_SIZE && cy < top;
+			      cy++ )
+			{
+				int32_t world_y =
+				    std::min( ( bottom + cy + 1 ) * scale, height ) - 1;
+
+				snapshot.voxels[ ChunkSnapshot::index( x, cy, z ) ] =
+				    column_voxel( world_y, height, biome );
+
+				if ( cy < 0 || cy == CHUNK_SIZE )
+				{
+					continue;
+				}
+
+				snapshot.x_rows[ cy + CHUNK_SIZE * z ] |= 1u << x;
+				snapshot.z_rows[ x + CHUNK_SIZE * cy ] |= 1u << z;
+				snapshot.slices[ 0 ] |= 1u << x;
+				snapshot.slices[ 1 ] |= 1u << cy;
+				snapshot.slices[ 2 ] |= 1u << z;
+			}
+		}
+	}
+
+	snapshot.empty = snapshot.slices[ 1 ] == 0;
+
+	return !snapshot.empty;
+}
+
+void
+LodTerrain::build_tile( Tile&             tile,
+                        int32_t           level,
+                        const glm::ivec2& position,
+                        const Rect&       hole )
+{
+	int32_t scale = 1 << level;
+	int32_t cells = CHUNK_SIZE / scale;
+
+	if ( !tile.built )
+	{
+		generate_heights( tile, level, position );
+	}
+
+	int32_t top = 0;
+
+	for ( int32_t z = 0; z < CHUNK_SIZE; z++ )
+	{
+		for ( int32_t x = 0; x < CHUNK_SIZE; x++ )
+		{
+			glm::ivec2 column = position * scale + glm::ivec2( x, z ) / cells;
+			bool inside = column.x >= hole.min.x && column.x < hole.max.x &&
+			              column.y >= hole.min.y && column.y < hole.max.y;
+
+			int32_t cell   = x + CHUNK_SIZE * z;
+			int32_t height = inside ? 0 : tile.heights[ cell ];
+			cell_heights[ cell ] = height;
+			cell_biomes[ cell ]  = tile.biomes[ cell ];
+			top                  = std::max( top, height );
+		}
+	}
+
+	stats.memory_bytes -= tile.vertices.capacity() * sizeof( Vertex ) +
+	                      tile.indices.capacity() * sizeof( uint32_t );
+	tile.vertices.clear();
+	tile.indices.clear();
+
+	// sections above highest cell are empty, terrain never goes below its
+	// base, so skirts need not reach into sections under it
+	int32_t section_height = CHUNK_SIZE * scale;
+	int32_t section_count  = ( top + section_height - 1 ) / section_height;
+	int32_t first_section  = TERRAIN_BASE_HEIGHT / section_height;
+
+	for ( int32_t y = first_section; y < section_count; y++ )
+	{
+		if ( !fill_snapshot( level, position, y ) )
+		{
+			continue;
+		}
+
+		mesh_snapshot(
+		    snapshot, section_vertices, section_indices, nullptr, false );
+
+		uint32_t base = uint32_t( tile.vertices.size() );
+		tile.vertices.insert( tile.vertices.end(),
+		                      section_vertices.begin(),
+		                      section_vertices.end() );
+		for ( uint32_t index : section_indices )
+		{
+			tile.indices.push_back( base + index );
+		}
+	}
+
+	tile.vertices.shrink_to_fit();
+	tile.indices.shrink_to_fit();
+	stats.memory_bytes += tile.vertices.capacity() * sizeof( Vertex ) +
+	                      tile.indices.capacity() * sizeof( uint32_t );
+
+	tile.hole  = hole;
+	tile.built = true;
+	stats.tiles_built++;
+}
+
+void
+LodTerrain::update( const glm::ivec2& new_center )
+{
+	if ( center_valid && new_center == center && !pending )
+	{
+		return;
+	}
+
+	center       = new_center;
+	center_valid = true;
+	pending      = false;
+	update_count++;
+	visible_tiles.clear();
+	stats.vertex_count = 0;
+
+	int32_t built = 0;
+
+	for ( int32_t level = 1; level <= LOD_LEVELS; level++ )
+	{
+		int32_t    scale = 1 << level;
+		Rect       inner = inner_rect( level );
+		glm::ivec2 middle( floor_div( center.x, scale ),
+		                   floor_div( center.y, scale ) );
+
+		for ( int32_t z = -LOD_TILE_RADIUS; z < LOD_TILE_RADIUS; z++ )
+		{
+			for ( int32_t x = -LOD_TILE_RADIUS; x < LOD_TILE_RADIUS; x++ )
+			{
+				glm::ivec2 position = middle + glm::ivec2( x, z );
+				Rect area { position * scale, position * scale + scale };
+				Rect hole { glm::max( area.min, inner.min ),
+				            glm::min( area.max, inner.max ) };
+
+				if ( hole == area )
+				{
+					continue;
+				}
+
+				if ( hole.min.x >= hole.max.x || hole.min.y >= hole.max.y )
+				{
+					hole = { glm::ivec2( 0 ), glm::ivec2( 0 ) };
+				}
+
+				Tile& tile =
+				    tiles[ glm::ivec3( position.x, level, position.y ) ];
+				tile.used_update = update_count;
+
+				if ( !tile.built || tile.hole != hole )
+				{
+					if ( built < LOD_TILES_PER_FRAME )
+					{
+						build_tile( tile, level, position, hole );
+						built++;
+					}
+					else
+					{
+						pending = true;
+					}
+				}
+
+				// outdated tile is drawn until rebuilt, better than a gap
+				if ( !tile.indices.empty() )
+				{
+					visible_tiles.push_back( &tile );
+					stats.vertex_count += tile.vertices.size();
+				}
+			}
+		}
+	}
+
+	// tiles which left every ring
+	for ( auto it = tiles.begin(); it != tiles.end(); )
+	{
+		if ( it->second.used_update == update_count )
+		{
+			++it;
+			continue;
+		}
+
+		stats.memory_bytes -=
+		    it->second.vertices.capacity() * sizeof( Vertex ) +
+		    it->second.indices.capacity() * sizeof( uint32_t );
+		it = tiles.erase( it );
+	}
+
+	stats.tile_count    = tiles.size();
+	stats.visible_tiles = visible_tiles.size();
+}
+
+void
+LodTerrain::push_meshes( MeshGenerator& mesh_generator ) const
+{
+	for ( const Tile* tile : visible_tiles )
+	{
+		mesh_generator.push_mesh( tile->vertices, tile->indices );
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/gtx/hash.hpp>
+#include "constants.hpp"
+#include "chunk.hpp"
+#include "chunk_snapshot.hpp"
+#include "vertex.hpp"
+
+class MeshGenerator;
+
+struct LodStats
+{
+	size_t tile_count;
+	size_t visible_tiles;
+	size_t vertex_count;
+	// vertices and indices of all tiles
+	size_t memory_bytes;
+	size_t tiles_built;
+};
+
+// far terrain beyond render distance, meshed straight from heightmaps so
+// no voxel data is kept. level L covers tiles of 2^L x 2^L columns where
+// one voxel stands for 2^L x 2^L x 2^L world voxels, highest voxel of
+// every cell is kept. each level leaves a hole where finer level draws.
+// tile sides are meshed against AIR, so they hang down as skirts and
+// close seams between levels and chunks in full resolution
+class LodTerrain
+{
+private:
+	struct Rect
+	{
+		// in columns, max is exclusive
+		glm::ivec2 min;
+		glm::ivec2 max;
+
+		bool
+		operator==( const Rect& other ) const
+		{
+			return min == other.min && max == other.max;
+		}
+
+		bool
+		operator!=( const Rect& other ) const
+		{
+			return !( *this == other );
+		}
+	};
+
+	struct Tile
+	{
+		// highest voxel of every cell and biome of column it comes from,
+		// kept so moving hole only remeshes
+		std::array<int32_t, CHUNK_SIZE_SQUARED>     heights;
+		std::array<Biome::Type, CHUNK_SIZE_SQUARED> biomes;
+		std::vector<Vertex>                         vertices;
+		std::vector<uint32_t>                       indices;
+		// columns of finer levels left out of this tile
+		Rect   hole;
+		bool   built;
+		size_t used_update;
+	};
+
+	// ( x, level, z ), x and z in tiles of that level
+	std::unordered_map<glm::ivec3, Tile> tiles;
+	std::vector<const Tile*>             visible_tiles;
+
+	glm::ivec2 center;
+	bool       center_valid;
+	// some tiles in view are not built yet or have an outdated hole
+	bool   pending;
+	size_t update_count;
+
+	LodStats stats;
+
+	// reused between tiles
+	Heightmap                                   column_heights;
+	std::array<int32_t, CHUNK_SIZE_SQUARED>     cell_heights;
+	std::array<Biome::Type, CHUNK_SIZE_SQUARED> cell_biomes;
+	ChunkSnapshot                               snapshot;
+	std::vector<Vertex>                         section_vertices;
+	std::vector<uint32_t>                       section_indices;
+
+	// columns drawn by finer levels than this one
+	Rect
+	inner_rect( int32_t level ) const;
+
+	void
+	generate_heights( Tile& tile, int32_t level, const glm::ivec2& position );
+
+	// remeshes tile with cells inside hole left AIR
+	void
+	build_tile( Tile&             tile,
+	            int32_t           level,
+	            const glm::ivec2& position,
+	            const Rect&       hole );
+
+	// section y of tile from cell heights, false when it is all AIR
+	bool
+	fill_snapshot( int32_t level, const glm::ivec2& position, int32_t y );
+
+public:
+	void
+	init();
+
+	void
+	shutdown();
+
+	// builds at most LOD_TILES_PER_FRAME tiles, nothing while center
+	// stays in the same chunk and all tiles are built
+	void
+	update( const glm::ivec2& center );
+
+	void
+	push_meshes( MeshGenerator& mesh_generator ) const;
+
+	const LodStats&
+	get_stats() const
+	{
+		return stats;
+	}
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+
+// doubly linked list threaded through T::lru_prev and T::lru_next, so
+// touching or removing an entry never allocates or searches. front is most
+// recently used. entries are owned by caller
+template <typename T>
+class LruList
+{
+private:
+	T*     head  = nullptr;
+	T*     tail  = nullptr;
+	size_t count = 0;
+
+public:
+	void
+	push_front( T* entry )
+	{
+		entry->lru_prev = nullptr;
+		entry->lru_next = head;
+
+		if ( head != nullptr )
+		{
+			head->lru_prev = entry;
+		}
+		else
+		{
+			tail = entry;
+		}
+
+		head = entry;
+		count++;
+	}
+
+	void
+	remove( T* entry )
+	{
+		if ( entry->lru_prev != nullptr )
+		{
+			entry->lru_prev->lru_next = entry->lru_next;
+		}
+		else
+		{
+			head = entry->lru_next;
+		}
+
+		if ( entry->lru_next != nullptr )
+		{
+			entry->lru_next->lru_prev = entry->lru_prev;
+		}
+		else
+		{
+			tail = entry->lru_prev;
+		}
+
+		entry->lru_prev = nullptr;
+		entry->lru_next = nullptr;
+		count--;
+	}
+
+	void
+	touch( T* entry )
+	{
+		if ( entry != head )
+		{
+			remove( entry );
+			push_front( entry );
+		}
+	}
+
+	void
+	clear()
+	{
+		head  = nullptr;
+		tail  = nullptr;
+		count = 0;
+	}
+
+	// least recently used
+	T*
+	back() const
+	{
+		return tail;
+	}
+
+	size_t
+	size() const
+	{
+		return count;
+	}
+};
@@ -46,7 +46,8 @@ end_frame( void );
 static void
 on_init( void )
 {
-	float3 position  = { 0.0f, 0.0f, 3.0f };
+	// above terrain which starts at TERRAIN_BASE_HEIGHT
+	float3 position  = { 0.0f, 96.0f, 3.0f };
 	float3 direction = { 0.0f, 0.0f, -1.0f };
 	float3 up        = { 0.0f, 1.0f, 0.0f };
 	float  aspect    = ft_window_get_aspect( ft_get_app_window() );
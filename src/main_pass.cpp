@@ -88,7 +88,8 @@ main_pass_execute( const struct ft_device*   device,
 	                            data->camera->direction[ 1 ],
 	                            data->camera->direction[ 2 ] );
 
-	data->chunk_manager.update_visible_chunks( camera_position );
+	data->chunk_manager.update_visible_chunks( camera_position,
+	                                           camera_direction );
 
 	data->mesh_generator.bind_buffers( cmd );
 	data->mesh_renderer.update( cmd,
@@ -180,7 +181,7 @@ register_main_pass( const ft_device* device,
 	data->mesh_renderer.init( device,
 	                          data->color_format,
 	                          FT_FORMAT_D32_SFLOAT );
-	data->chunk_manager.init( &data->mesh_generator );
+	data->chunk_manager.init( &data->mesh_generator, WORLD_DIRECTORY );
 	data->ui_renderer.init( device, color_format, FT_FORMAT_D32_SFLOAT );
 
 	ft_render_pass* pass;
@@ -203,5 +204,6 @@ free_main_pass_data()
 	main_pass_data->ui_renderer.shutdown();
 	main_pass_data->mesh_renderer.shutdown();
 	main_pass_data->mesh_generator.shutdown();
+	main_pass_data->chunk_manager.shutdown();
 	delete main_pass_data;
 }
@@ -1,367 +1,726 @@
-#include <future>
-#include "quad.hpp"
-#include "mesh_generator.hpp"
-#include "coordinates.hpp"
-#include "chunk_manager.hpp"
-
-void
-MeshGenerator::create_buffers()
-{
-	struct ft_buffer_info info = {};
-	info.memory_usage          = FT_MEMORY_USAGE_CPU_TO_GPU;
-	info.descriptor_type       = FT_DESCRIPTOR_TYPE_VERTEX_BUFFER;
-	info.size                  = VERTEX_BUFFER_SIZE;
-	ft_create_buffer( device, &info, &vertex_buffer.buffer );
-	info.descriptor_type = FT_DESCRIPTOR_TYPE_INDEX_BUFFER;
-	info.size            = INDEX_BUFFER_SIZE;
-	ft_create_buffer( device, &info, &index_buffer.buffer );
-	vertex_buffer.offset = 0;
-	index_buffer.offset  = 0;
-
-	ft_map_memory( device, vertex_buffer.buffer );
-	ft_map_memory( device, index_buffer.buffer );
-}
-
-void
-MeshGenerator::destroy_buffers()
-{
-	ft_unmap_memory( device, vertex_buffer.buffer );
-	ft_unmap_memory( device, index_buffer.buffer );
-	ft_destroy_buffer( device, vertex_buffer.buffer );
-	ft_destroy_buffer( device, index_buffer.buffer );
-}
-
-void
-MeshGenerator::init( const struct ft_device* device )
-{
-	this->device = device;
-	create_buffers();
-}
-
-void
-MeshGenerator::shutdown()
-{
-	destroy_buffers();
-}
-
-static inline void
-push_indices( Indices& indices, Index& m )
-{
-	indices.insert( indices.end(),
-	                { Index( Index( 0 ) + m ),
-	                  Index( Index( 1 ) + m ),
-	                  Index( Index( 2 ) + m ),
-	                  Index( Index( 2 ) + m ),
-	                  Index( Index( 3 ) + m ),
-	                  Index( Index( 0 ) + m ) } );
-	m += 4;
-}
-
-MeshGenerator::MeshData&
-MeshGenerator::generate_mesh_data( const Chunk& chunk )
-{
-	if ( mesh_data_map.find( chunk.position ) != mesh_data_map.end() )
-	{
-		if ( chunk.modified == false )
-		{
-			MeshData& data         = mesh_data_map[ chunk.position ];
-			data.last_access_frame = frame_count;
-			return data;
-		}
-	}
-
-	chunk.modified = false;
-
-	MeshData& data         = mesh_data_map[ chunk.position ];
-	data.last_access_frame = frame_count;
-	data.vertices.clear();
-	data.indices.clear();
-
-	Index m = 0;
-
-	data.vertices.reserve( 4000 );
-	data.indices.reserve( 4000 * 6 );
-
-	// TODO: refactor
-	// TODO: optimize
-
-	struct VoxelFace
-	{
-		Voxel::Type voxel;
-		Face::Type  face;
-	};
-
-	int        i, j, k, l, w, h, u, v, n;
-	Face::Type face;
-
-	int32_t x[ 3 ]  = { 0, 0, 0 };
-	int32_t q[ 3 ]  = { 0, 0, 0 };
-	int32_t du[ 3 ] = { 0, 0, 0 };
-	int32_t dv[ 3 ] = { 0, 0, 0 };
-
-	VoxelFace mask[ CHUNK_SIZE_SQUARED ];
-	memset( mask, 0, sizeof( mask ) );
-
-	VoxelFace voxel_face0, voxel_face1;
-
-	for ( bool back_face = true, b = false; b != back_face;
-	      back_face = back_face && b, b = !b )
-	{
-		for ( int d = 0; d < 3; d++ )
-		{
-			u = ( d + 1 ) % 3;
-			v = ( d + 2 ) % 3;
-
-			x[ 0 ] = 0;
-			x[ 1 ] = 0;
-			x[ 2 ] = 0;
-
-			q[ 0 ] = 0;
-			q[ 1 ] = 0;
-			q[ 2 ] = 0;
-			q[ d ] = 1;
-
-			if ( d == 0 )
-			{
-				face = back_face ? Face::LEFT : Face::RIGHT;
-			}
-			else if ( d == 1 )
-			{
-				face = back_face ? Face::BOTTOM : Face::TOP;
-			}
-			else if ( d == 2 )
-			{
-				face = back_face ? Face::BACK : Face::FRONT;
-			}
-
-			for ( x[ d ] = -1; x[ d ] < CHUNK_SIZE; )
-			{
-				n = 0;
-
-				for ( x[ v ] = 0; x[ v ] < CHUNK_SIZE; x[ v ]++ )
-				{
-					for ( x[ u ] = 0; x[ u ] < CHUNK_SIZE; x[ u ]++ )
-					{
-						voxel_face0 =
-						    ( x[ d ] >= 0 )
-						        ? VoxelFace { chunk.get_voxel(
-						                          { x[ 0 ], x[ 1 ], x[ 2 ] } ),
-						                      face }
-						        : VoxelFace { Voxel::AIR };
-						voxel_face1 =
-						    ( x[ d ] < CHUNK_SIZE - 1 )
-						        ? VoxelFace { chunk.get_voxel(
-						                          { x[ 0 ] + q[ 0 ],
-						                            x[ 1 ] + q[ 1 ],
-						                            x[ 2 ] + q[ 2 ] } ),
-						                      face }
-						        : VoxelFace { Voxel::AIR };
-
-						mask[ n++ ] =
-						    ( ( voxel_face0.voxel != Voxel::AIR &&
-						        voxel_face1.voxel != Voxel::AIR &&
-						        voxel_face0.voxel == voxel_face1.voxel ) )
-						        ? VoxelFace { Voxel::AIR }
-						    : back_face ? voxel_face1
-						                : voxel_face0;
-					}
-				}
-
-				x[ d ]++;
-
-				n = 0;
-
-				for ( j = 0; j < CHUNK_SIZE; j++ )
-				{
-					for ( i = 0; i < CHUNK_SIZE; )
-					{
-						if ( mask[ n ].voxel != Voxel::AIR )
-						{
-							for ( w = 1; i + w < CHUNK_SIZE &&
-							             mask[ n + w ].voxel != Voxel::AIR &&
-							             mask[ n + w ].voxel == mask[ n ].voxel;
-							      w++ )
-							{
-							}
-
-							bool done = false;
-
-							for ( h = 1; j + h < CHUNK_SIZE; h++ )
-							{
-								for ( k = 0; k < w; k++ )
-								{
-									if ( mask[ n + k + h * CHUNK_SIZE ].voxel ==
-									         Voxel::AIR ||
-									     !( mask[ n + k + h * CHUNK_SIZE ]
-									            .voxel == mask[ n ].voxel ) )
-									{
-										done = true;
-										break;
-									}
-								}
-
-								if ( done )
-								{
-									break;
-								}
-							}
-
-							x[ u ] = i;
-							x[ v ] = j;
-
-							du[ 0 ] = 0;
-							du[ 1 ] = 0;
-							du[ 2 ] = 0;
-							du[ u ] = w;
-
-							dv[ 0 ] = 0;
-							dv[ 1 ] = 0;
-							dv[ 2 ] = 0;
-							dv[ v ] = h;
-
-							glm::vec2 uv;
-							get_uv( uv, mask[ n ].voxel, mask[ n ].face );
-
-							Vertex v0( glm::ivec3( x[ 0 ], x[ 1 ], x[ 2 ] ) +
-							               chunk.position * CHUNK_SIZE,
-							           uv,
-							           mask[ n ].face );
-
-							Vertex v1( glm::ivec3( x[ 0 ] + du[ 0 ],
-							                       x[ 1 ] + du[ 1 ],
-							                       x[ 2 ] + du[ 2 ] ) +
-							               chunk.position * CHUNK_SIZE,
-							           uv,
-							           mask[ n ].face );
-
-							Vertex v2(
-							    glm::ivec3( x[ 0 ] + du[ 0 ] + dv[ 0 ],
-							                x[ 1 ] + du[ 1 ] + dv[ 1 ],
-							                x[ 2 ] + du[ 2 ] + dv[ 2 ] ) +
-							        chunk.position * CHUNK_SIZE,
-							    uv,
-							    mask[ n ].face );
-
-							Vertex v3( glm::ivec3( x[ 0 ] + dv[ 0 ],
-							                       x[ 1 ] + dv[ 1 ],
-							                       x[ 2 ] + dv[ 2 ] ) +
-							               chunk.position * CHUNK_SIZE,
-							           uv,
-							           mask[ n ].face );
-
-							switch ( mask[ n ].face )
-							{
-							case Face::BOTTOM:
-							case Face::BACK:
-							case Face::LEFT:
-							{
-								data.vertices.insert( data.vertices.end(),
-								                      { v3, v2, v1, v0 } );
-								break;
-							}
-							case Face::TOP:
-							case Face::RIGHT:
-							case Face::FRONT:
-							{
-								data.vertices.insert( data.vertices.end(),
-								                      { v0, v1, v2, v3 } );
-								break;
-							}
-							}
-
-							push_indices( data.indices, m );
-
-							for ( l = 0; l < h; ++l )
-							{
-								for ( k = 0; k < w; ++k )
-								{
-									mask[ n + k + l * CHUNK_SIZE ].voxel =
-									    Voxel::AIR;
-								}
-							}
-
-							i += w;
-							n += w;
-						}
-						else
-						{
-							i++;
-							n++;
-						}
-					}
-				}
-			}
-		}
-	}
-
-	return data;
-}
-
-void
-MeshGenerator::upload_mesh( const MeshData& data )
-{
-	const auto& vertices = data.vertices;
-	const auto& indices  = data.indices;
-
-	reset_if_need( vertices, indices );
-
-	void* dst =
-	    ( uint8_t* ) vertex_buffer.buffer->mapped_memory + vertex_buffer.offset;
-	uint64_t v_size = vertices.size() * sizeof( Vertex );
-	memcpy( dst, vertices.data(), v_size );
-	dst = ( uint8_t* ) index_buffer.buffer->mapped_memory + index_buffer.offset;
-	uint64_t i_size = indices.size() * sizeof( Index );
-	memcpy( dst, indices.data(), i_size );
-
-	Mesh mesh;
-
-	mesh.vertex_offset = vertex_buffer.offset / sizeof( Vertex );
-	mesh.first_index   = index_buffer.offset / sizeof( Index );
-	mesh.index_count   = indices.size();
-
-	meshes.push_back( std::move( mesh ) );
-
-	vertex_buffer.offset += v_size;
-	index_buffer.offset += i_size;
-}
-
-void
-MeshGenerator::push_chunk( const Chunk& chunk )
-{
-	upload_mesh( generate_mesh_data( chunk ) );
-}
-
-void
-MeshGenerator::push_chunks( const std::list<Chunk*>& chunks )
-{
-	for ( const Chunk* chunk : chunks )
-	{
-		upload_mesh( generate_mesh_data( *chunk ) );
-	}
-}
-
-void
-MeshGenerator::pop_chunk()
-{
-	meshes.pop_front();
-}
-
-void
-MeshGenerator::reset_if_need( const Vertices& vertices, const Indices& indices )
-{
-	if ( ( vertex_buffer.offset + vertices.size() * sizeof( Vertex ) >
-	       VERTEX_BUFFER_SIZE ) ||
-	     ( index_buffer.offset + indices.size() * sizeof( Index ) >
-	       INDEX_BUFFER_SIZE ) )
-	{
-		vertex_buffer.offset = 0;
-		index_buffer.offset  = 0;
-	}
-}
-
-void
-MeshGenerator::bind_buffers( struct ft_command_buffer* cmd ) const
-{
-	ft_cmd_bind_vertex_buffer( cmd, vertex_buffer.buffer, 0 );
-	ft_cmd_bind_index_buffer( cmd, index_buffer.buffer, 0, FT_INDEX_TYPE_U32 );
-}
+#include <cstdlib>
+#include <future>
+#include "quad.hpp"
+#include "mesh_generator.hpp"
+#include "coordinates.hpp"
+#include "chunk_manager.hpp"
+
+void
+MeshGenerator::create_buffers()
+{
+	vertex_buffer.offset = 0;
+	index_buffer.offset  = 0;
+
+	// without device meshes only go to host memory, benchmarks mesh so
+	if ( device == nullptr )
+	{
+		vertex_buffer.buffer                = new ft_buffer {};
+		vertex_buffer.buffer->mapped_memory = std::malloc( VERTEX_BUFFER_SIZE );
+		index_buffer.buffer                 = new ft_buffer {};
+		index_buffer.buffer->mapped_memory  = std::malloc( INDEX_BUFFER_SIZE );
+		return;
+	}
+
+	struct ft_buffer_info info = {};
+	info.memory_usage          = FT_MEMORY_USAGE_CPU_TO_GPU;
+	info.descriptor_type       = FT_DESCRIPTOR_TYPE_VERTEX_BUFFER;
+	info.size                  = VERTEX_BUFFER_SIZE;
+	ft_create_buffer( device, &info, &vertex_buffer.buffer );
+	info.descriptor_type = FT_DESCRIPTOR_TYPE_INDEX_BUFFER;
+	info.size            = INDEX_BUFFER_SIZE;
+	ft_create_buffer( device, &info, &index_buffer.buffer );
+
+	ft_map_memory( device, vertex_buffer.buffer );
+	ft_map_memory( device, index_buffer.buffer );
+}
+
+void
+MeshGenerator::destroy_buffers()
+{
+	if ( device == nullptr )
+	{
+		std::free( vertex_buffer.buffer->mapped_memory );
+		std::free( index_buffer.buffer->mapped_memory );
+		delete vertex_buffer.buffer;
+		delete index_buffer.buffer;
+		return;
+	}
+
+	ft_unmap_memory( device, vertex_buffer.buffer );
+	ft_unmap_memory( device, index_buffer.buffer );
+	ft_destroy_buffer( device, vertex_buffer.buffer );
+	ft_destroy_buffer( device, index_buffer.buffer );
+}
+
+void
+MeshGenerator::init( const struct ft_device* device )
+{
+	this->device       = device;
+	mesh_stats         = {};
+	flat_quads_counted = false;
+	create_buffers();
+}
+
+void
+MeshGenerator::shutdown()
+{
+	destroy_buffers();
+}
+
+// flipped quad is split along its other diagonal
+static inline void
+push_indices( Indices& indices, Index& m, bool flip )
+{
+	Index o = flip ? 1 : 0;
+
+	indices.insert( indices.end(),
+	                { Index( Index( 0 + o ) + m ),
+	                  Index( Index( 1 + o ) + m ),
+	                  Index( Index( 2 + o ) + m ),
+	                  Index( Index( 2 + o ) + m ),
+	                  Index( Index( ( 3 + o ) % 4 ) + m ),
+	                  Index( Index( 0 + o ) + m ) } );
+	m += 4;
+}
+
+struct VoxelFace
+{
+	Voxel::Type voxel;
+	Face::Type  face;
+	// of voxel face looks into, faces merge only when it is equal
+	Light light;
+	// ambient occlusion of corners in order of quad vertices, two bits
+	// each, 0 is darkest. faces merge only when it is equal too
+	uint8_t ao;
+
+	uint8_t
+	get_ao( int32_t corner ) const
+	{
+		return ( ao >> ( 2 * corner ) ) & 3;
+	}
+
+	// occlusion does not change along u, so quad may grow that way without
+	// stretching its gradient
+	bool
+	is_flat_along_u() const
+	{
+		return get_ao( 0 ) == get_ao( 1 ) && get_ao( 3 ) == get_ao( 2 );
+	}
+
+	bool
+	is_flat_along_v() const
+	{
+		return get_ao( 0 ) == get_ao( 3 ) && get_ao( 1 ) == get_ao( 2 );
+	}
+
+	bool
+	has_same_surface( const VoxelFace& other ) const
+	{
+		return other.voxel != Voxel::AIR && other.voxel == voxel &&
+		       other.light == light;
+	}
+
+	bool
+	merges_with( const VoxelFace& other ) const
+	{
+		return has_same_surface( other ) && other.ao == ao;
+	}
+};
+
+// 0 when both sides are occluded, corner cannot be seen through them
+static inline uint8_t
+get_corner_ao( bool side1, bool side2, bool corner )
+{
+	if ( side1 && side2 )
+	{
+		return 0;
+	}
+
+	return uint8_t( 3 - ( side1 + side2 + corner ) );
+}
+
+// occlusion of face looking into snapshot voxel front, from opaque voxels
+// around it in plane of face. su and sv step one voxel along u and v,
+// opaque is is_opaque of every voxel type
+static inline uint8_t
+get_face_ao( const ChunkSnapshot& snapshot,
+             const bool*          opaque,
+             int32_t              front,
+             int32_t              su,
+             int32_t              sv )
+{
+	const Voxel::Type* voxels = snapshot.voxels.data() + front;
+
+	bool left       = opaque[ voxels[ -su ] ];
+	bool right      = opaque[ voxels[ su ] ];
+	bool down       = opaque[ voxels[ -sv ] ];
+	bool up         = opaque[ voxels[ sv ] ];
+	bool left_down  = opaque[ voxels[ -su - sv ] ];
+	bool right_down = opaque[ voxels[ su - sv ] ];
+	bool right_up   = opaque[ voxels[ su + sv ] ];
+	bool left_up    = opaque[ voxels[ -su + sv ] ];
+
+	return uint8_t( get_corner_ao( left, down, left_down ) |
+	                get_corner_ao( right, down, right_down ) << 2 |
+	                get_corner_ao( right, up, right_up ) << 4 |
+	                get_corner_ao( left, up, left_up ) << 6 );
+}
+
+// quads greedy merging would make of mask if occlusion did not split them
+static size_t
+get_flat_quad_count( const VoxelFace* mask )
+{
+	VoxelFace flat[ CHUNK_SIZE_SQUARED ];
+	memcpy( flat, mask, sizeof( flat ) );
+
+	size_t quads = 0;
+
+	for ( int32_t j = 0, n = 0; j < CHUNK_SIZE; j++ )
+	{
+		for ( int32_t i = 0; i < CHUNK_SIZE; i++, n++ )
+		{
+			if ( flat[ n ].voxel == Voxel::AIR )
+			{
+				continue;
+			}
+
+			int32_t w, h;
+
+			for ( w = 1; i + w < CHUNK_SIZE &&
+			             flat[ n ].has_same_surface( flat[ n + w ] );
+			      w++ )
+			{
+			}
+
+			for ( h = 1; j + h < CHUNK_SIZE; h++ )
+			{
+				int32_t k = 0;
+
+				while ( k < w && flat[ n ].has_same_surface(
+				                     flat[ n + k + h * CHUNK_SIZE ] ) )
+				{
+					k++;
+				}
+
+				if ( k < w )
+				{
+					break;
+				}
+			}
+
+			for ( int32_t l = 0; l < h; l++ )
+			{
+				for ( int32_t k = 0; k < w; k++ )
+				{
+					flat[ n + k + l * CHUNK_SIZE ].voxel = Voxel::AIR;
+				}
+			}
+
+			quads++;
+		}
+	}
+
+	return quads;
+}
+
+// true when neither slice around x[ d ] has voxels in row x[ v ], so the
+// whole mask row is AIR. only x and z rows are tracked by chunk
+static inline bool
+mask_row_is_empty( const ChunkSnapshot& snapshot, int32_t d, const int32_t* x )
+{
+	uint16_t row = 0;
+
+	for ( int32_t s = x[ d ]; s <= x[ d ] + 1; s++ )
+	{
+		if ( s < 0 || s >= CHUNK_SIZE )
+		{
+			continue;
+		}
+
+		if ( d == 2 )
+		{
+			row |= snapshot.x_rows[ x[ 1 ] + CHUNK_SIZE * s ];
+		}
+		else if ( d == 1 )
+		{
+			row |= snapshot.z_rows[ x[ 0 ] + CHUNK_SIZE * s ];
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return row == 0;
+}
+
+MeshGenerator::MeshData&
+MeshGenerator::generate_mesh_data( const Chunk& chunk )
+{
+	auto [ it, inserted ]  = mesh_data_map.try_emplace( chunk.position );
+	MeshData& data         = it->second;
+	data.last_access_frame = frame_count;
+
+	if ( inserted )
+	{
+		data.position     = chunk.position;
+		data.memory_bytes = 0;
+		mesh_lru.push_front( &data );
+	}
+	else
+	{
+		mesh_lru.touch( &data );
+
+		if ( chunk.modified == false )
+		{
+			return data;
+		}
+	}
+
+	chunk.modified = false;
+
+	chunk.chunk_manager->build_snapshot( chunk, snapshot );
+	mesh_snapshot( snapshot,
+	               mesh_vertices,
+	               mesh_indices,
+	               &mesh_stats,
+	               flat_quads_counted );
+
+	// reserve of mesher would otherwise stay in cache for every chunk
+	data.vertices = Vertices( mesh_vertices.begin(), mesh_vertices.end() );
+	data.indices  = Indices( mesh_indices.begin(), mesh_indices.end() );
+
+	mesh_bytes -= data.memory_bytes;
+	data.memory_bytes = data.vertices.capacity() * sizeof( Vertex ) +
+	                    data.indices.capacity() * sizeof( Index );
+	mesh_bytes += data.memory_bytes;
+
+	return data;
+}
+
+void
+MeshGenerator::erase_mesh_data( MeshData& data )
+{
+	mesh_lru.remove( &data );
+	mesh_bytes -= data.memory_bytes;
+	mesh_data_map.erase( data.position );
+}
+
+void
+MeshGenerator::drop_chunk( const glm::ivec3& chunk_position )
+{
+	auto it = mesh_data_map.find( chunk_position );
+
+	if ( it != mesh_data_map.end() )
+	{
+		erase_mesh_data( it->second );
+	}
+}
+
+void
+MeshGenerator::evict_meshes()
+{
+	for ( int32_t i = 0; i < MESH_EVICTIONS_PER_FRAME; i++ )
+	{
+		MeshData* data = mesh_lru.back();
+
+		// rest of the list was drawn last frame
+		if ( mesh_bytes <= MESH_MEMORY_BUDGET || data == nullptr ||
+		     data->last_access_frame == frame_count )
+		{
+			return;
+		}
+
+		erase_mesh_data( *data );
+	}
+}
+
+void
+mesh_snapshot( const ChunkSnapshot& snapshot,
+               Vertices&            vertices,
+               Indices&             indices,
+               MeshStats*           stats,
+               bool                 count_flat_quads )
+{
+	vertices.clear();
+	indices.clear();
+
+	if ( snapshot.empty )
+	{
+		return;
+	}
+
+	if ( stats != nullptr )
+	{
+		stats->meshes++;
+	}
+
+	Index m = 0;
+
+	vertices.reserve( 4000 );
+	indices.reserve( 4000 * 6 );
+
+	// TODO: refactor
+	// TODO: optimize
+
+	int        i, j, k, l, w, h, u, v, n;
+	Face::Type face;
+	// snapshot index steps along u and v
+	int32_t su, sv;
+
+	// ambient occlusion looks up a lot of voxels, table keeps it inline
+	bool opaque[ Voxel::COUNT ];
+
+	for ( i = 0; i < Voxel::COUNT; i++ )
+	{
+		opaque[ i ] = is_opaque( Voxel::Type( i ) );
+	}
+
+	int32_t x[ 3 ]  = { 0, 0, 0 };
+	int32_t q[ 3 ]  = { 0, 0, 0 };
+	int32_t du[ 3 ] = { 0, 0, 0 };
+	int32_t dv[ 3 ] = { 0, 0, 0 };
+
+	VoxelFace mask[ CHUNK_SIZE_SQUARED ];
+	memset( mask, 0, sizeof( mask ) );
+
+	VoxelFace voxel_face0, voxel_face1;
+
+	for ( bool back_face = true, b = false; b != back_face;
+	      back_face = back_face && b, b = !b )
+	{
+		for ( int d = 0; d < 3; d++ )
+		{
+			u  = ( d + 1 ) % 3;
+			v  = ( d + 2 ) % 3;
+			su = ChunkSnapshot::stride( u );
+			sv = ChunkSnapshot::stride( v );
+
+			x[ 0 ] = 0;
+			x[ 1 ] = 0;
+			x[ 2 ] = 0;
+
+			q[ 0 ] = 0;
+			q[ 1 ] = 0;
+			q[ 2 ] = 0;
+			q[ d ] = 1;
+
+			if ( d == 0 )
+			{
+				face = back_face ? Face::LEFT : Face::RIGHT;
+			}
+			else if ( d == 1 )
+			{
+				face = back_face ? Face::BOTTOM : Face::TOP;
+			}
+			else if ( d == 2 )
+			{
+				face = back_face ? Face::BACK : Face::FRONT;
+			}
+
+			for ( x[ d ] = -1; x[ d ] < CHUNK_SIZE; )
+			{
+				// both slices empty, no faces between them
+				if ( ( ( snapshot.slices[ d ] << 1 ) >> ( x[ d ] + 1 ) & 3 ) ==
+				     0 )
+				{
+					x[ d ]++;
+					continue;
+				}
+
+				n = 0;
+
+				for ( x[ v ] = 0; x[ v ] < CHUNK_SIZE; x[ v ]++ )
+				{
+					if ( mask_row_is_empty( snapshot, d, x ) )
+					{
+						for ( i = 0; i < CHUNK_SIZE; i++ )
+						{
+							mask[ n++ ] = VoxelFace {};
+						}
+						continue;
+					}
+
+					for ( x[ u ] = 0; x[ u ] < CHUNK_SIZE; x[ u ]++ )
+					{
+						voxel_face0 = VoxelFace {
+						    snapshot.get_voxel( x[ 0 ], x[ 1 ], x[ 2 ] ),
+						    face,
+						    snapshot.get_light( x[ 0 ] + q[ 0 ],
+						                        x[ 1 ] + q[ 1 ],
+						                        x[ 2 ] + q[ 2 ] ),
+						    0 };
+						voxel_face1 = VoxelFace {
+						    snapshot.get_voxel( x[ 0 ] + q[ 0 ],
+						                        x[ 1 ] + q[ 1 ],
+						                        x[ 2 ] + q[ 2 ] ),
+						    face,
+						    snapshot.get_light( x[ 0 ], x[ 1 ], x[ 2 ] ),
+						    0 };
+
+						// apron voxels only hide faces, their own faces
+						// belong to neighbor chunk
+						VoxelFace& cell = mask[ n++ ];
+						cell =
+						    ( ( voxel_face0.voxel != Voxel::AIR &&
+						        voxel_face1.voxel != Voxel::AIR &&
+						        voxel_face0.voxel == voxel_face1.voxel ) )
+						        ? VoxelFace {}
+						    : back_face
+						        ? ( x[ d ] < CHUNK_SIZE - 1
+						                ? voxel_face1
+						                : VoxelFace {} )
+						        : ( x[ d ] >= 0 ? voxel_face0
+						                        : VoxelFace {} );
+
+						if ( cell.voxel == Voxel::AIR )
+						{
+							continue;
+						}
+
+						int32_t front =
+						    ChunkSnapshot::index( x[ 0 ], x[ 1 ], x[ 2 ] ) +
+						    ( back_face ? 0 : ChunkSnapshot::stride( d ) );
+
+						// face between two opaque voxels is never seen, it
+						// is left unoccluded so it merges as before
+						if ( opaque[ snapshot.voxels[ front ] ] )
+						{
+							cell.ao = 0xff;
+							continue;
+						}
+
+						cell.ao =
+						    get_face_ao( snapshot, opaque, front, su, sv );
+					}
+				}
+
+				x[ d ]++;
+
+				if ( stats != nullptr && count_flat_quads )
+				{
+					stats->flat_quads += get_flat_quad_count( mask );
+				}
+
+				n = 0;
+
+				for ( j = 0; j < CHUNK_SIZE; j++ )
+				{
+					for ( i = 0; i < CHUNK_SIZE; )
+					{
+						if ( mask[ n ].voxel != Voxel::AIR )
+						{
+							// occlusion gradient may not be stretched, so
+							// quad grows only where it is flat
+							for ( w = 1; i + w < CHUNK_SIZE &&
+							             mask[ n ].is_flat_along_u() &&
+							             mask[ n ].merges_with( mask[ n + w ] );
+							      w++ )
+							{
+							}
+
+							bool done = false;
+
+							for ( h = 1; j + h < CHUNK_SIZE &&
+							             mask[ n ].is_flat_along_v();
+							      h++ )
+							{
+								for ( k = 0; k < w; k++ )
+								{
+									const VoxelFace& next =
+									    mask[ n + k + h * CHUNK_SIZE ];
+
+									if ( !mask[ n ].merges_with( next ) )
+									{
+										done = true;
+										break;
+									}
+								}
+
+								if ( done )
+								{
+									break;
+								}
+							}
+
+							x[ u ] = i;
+							x[ v ] = j;
+
+							du[ 0 ] = 0;
+							du[ 1 ] = 0;
+							du[ 2 ] = 0;
+							du[ u ] = w;
+
+							dv[ 0 ] = 0;
+							dv[ 1 ] = 0;
+							dv[ 2 ] = 0;
+							dv[ v ] = h;
+
+							glm::vec2 uv;
+							get_uv( uv, mask[ n ].voxel, mask[ n ].face );
+
+							// lod snapshots stand for scale^3 voxels per voxel
+							int32_t    scale = snapshot.scale;
+							glm::ivec3 p0( x[ 0 ], x[ 1 ], x[ 2 ] );
+							glm::ivec3 d0( du[ 0 ], du[ 1 ], du[ 2 ] );
+							glm::ivec3 d1( dv[ 0 ], dv[ 1 ], dv[ 2 ] );
+							p0 += snapshot.position * CHUNK_SIZE;
+
+							const VoxelFace& quad  = mask[ n ];
+							float            light = quad.light;
+
+							Vertex v0( p0 * scale,
+							           uv,
+							           quad.face,
+							           light,
+							           quad.get_ao( 0 ) );
+							Vertex v1( ( p0 + d0 ) * scale,
+							           uv,
+							           quad.face,
+							           light,
+							           quad.get_ao( 1 ) );
+							Vertex v2( ( p0 + d0 + d1 ) * scale,
+							           uv,
+							           quad.face,
+							           light,
+							           quad.get_ao( 2 ) );
+							Vertex v3( ( p0 + d1 ) * scale,
+							           uv,
+							           quad.face,
+							           light,
+							           quad.get_ao( 3 ) );
+
+							// split along brighter diagonal, so dark corner
+							// does not bleed over whole quad
+							bool split_13 =
+							    quad.get_ao( 0 ) + quad.get_ao( 2 ) <
+							    quad.get_ao( 1 ) + quad.get_ao( 3 );
+							bool flip = false;
+
+							switch ( mask[ n ].face )
+							{
+							case Face::BOTTOM:
+							case Face::BACK:
+							case Face::LEFT:
+							{
+								vertices.insert( vertices.end(),
+								                 { v3, v2, v1, v0 } );
+								// v3 to v1 is already diagonal of this order
+								flip = !split_13;
+								break;
+							}
+							case Face::TOP:
+							case Face::RIGHT:
+							case Face::FRONT:
+							{
+								vertices.insert( vertices.end(),
+								                 { v0, v1, v2, v3 } );
+								flip = split_13;
+								break;
+							}
+							}
+
+							push_indices( indices, m, flip );
+
+							if ( stats != nullptr )
+							{
+								stats->quads++;
+							}
+
+							for ( l = 0; l < h; ++l )
+							{
+								for ( k = 0; k < w; ++k )
+								{
+									mask[ n + k + l * CHUNK_SIZE ].voxel =
+									    Voxel::AIR;
+								}
+							}
+
+							i += w;
+							n += w;
+						}
+						else
+						{
+							i++;
+							n++;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void
+MeshGenerator::push_mesh( const Vertices& vertices, const Indices& indices )
+{
+	reset_if_need( vertices, indices );
+
+	void* dst =
+	    ( uint8_t* ) vertex_buffer.buffer->mapped_memory + vertex_buffer.offset;
+	uint64_t v_size = vertices.size() * sizeof( Vertex );
+	memcpy( dst, vertices.data(), v_size );
+	dst = ( uint8_t* ) index_buffer.buffer->mapped_memory + index_buffer.offset;
+	uint64_t i_size = indices.size() * sizeof( Index );
+	memcpy( dst, indices.data(), i_size );
+
+	Mesh mesh;
+
+	mesh.vertex_offset = vertex_buffer.offset / sizeof( Vertex );
+	mesh.first_index   = index_buffer.offset / sizeof( Index );
+	mesh.index_count   = indices.size();
+
+	meshes.push_back( std::move( mesh ) );
+
+	vertex_buffer.offset += v_size;
+	index_buffer.offset += i_size;
+}
+
+void
+MeshGenerator::push_chunk( const Chunk& chunk )
+{
+	const MeshData& data = generate_mesh_data( chunk );
+	push_mesh( data.vertices, data.indices );
+}
+
+void
+MeshGenerator::push_chunks( const std::vector<Chunk*>& chunks )
+{
+	for ( const Chunk* chunk : chunks )
+	{
+		const MeshData& data = generate_mesh_data( *chunk );
+		push_mesh( data.vertices, data.indices );
+	}
+}
+
+void
+MeshGenerator::remesh_chunk( const Chunk& chunk )
+{
+	generate_mesh_data( chunk );
+}
+
+void
+MeshGenerator::pop_chunk()
+{
+	meshes.pop_front();
+}
+
+void
+MeshGenerator::reset_if_need( const Vertices& vertices, const Indices& indices )
+{
+	if ( ( vertex_buffer.offset + vertices.size() * sizeof( Vertex ) >
+	       VERTEX_BUFFER_SIZE ) ||
+	     ( index_buffer.offset + indices.size() * sizeof( Index ) >
+	       INDEX_BUFFER_SIZE ) )
+	{
+		vertex_buffer.offset = 0;
+		index_buffer.offset  = 0;
+	}
+}
+
+void
+MeshGenerator::bind_buffers( struct ft_command_buffer* cmd ) const
+{
+	ft_cmd_bind_vertex_buffer( cmd, vertex_buffer.buffer, 0 );
+	ft_cmd_bind_index_buffer( cmd, index_buffer.buffer, 0, FT_INDEX_TYPE_U32 );
+}
@@ -9,6 +9,8 @@
 #include <glm/gtx/hash.hpp>
 #include "constants.hpp"
 #include "chunk.hpp"
+#include "chunk_snapshot.hpp"
+#include "lru_list.hpp"
 #include "vertex.hpp"
 #include "mesh.hpp"
 
@@ -17,6 +19,25 @@ using Vertices = std::vector<Vertex>;
 using Indices  = std::vector<Index>;
 using Meshes   = std::list<Mesh>;
 
+struct MeshStats
+{
+	// non empty snapshots meshed
+	size_t meshes;
+	size_t quads;
+	// quads same meshes would have if ambient occlusion did not split
+	// merges, counted only when asked for
+	size_t flat_quads;
+};
+
+// greedy meshing, reads only snapshot so it is safe to run off main thread.
+// stats may be nullptr, counting flat quads costs a second merge pass
+void
+mesh_snapshot( const ChunkSnapshot& snapshot,
+               Vertices&            vertices,
+               Indices&             indices,
+               MeshStats*           stats,
+               bool                 count_flat_quads );
+
 class MeshGenerator
 {
 private:
@@ -32,9 +53,13 @@ private:
 
 	struct MeshData
 	{
-		Vertices vertices;
-		Indices  indices;
-		size_t   last_access_frame;
+		glm::vec3 position;
+		Vertices  vertices;
+		Indices   indices;
+		size_t    last_access_frame;
+		size_t    memory_bytes;
+		MeshData* lru_prev;
+		MeshData* lru_next;
 	};
 
 	const struct ft_device* device = nullptr;
@@ -43,7 +68,17 @@ private:
 	MeshBuffer index_buffer;
 
 	std::unordered_map<glm::vec3, MeshData> mesh_data_map;
-	Meshes                                  meshes;
+	// map nodes do not move on rehash, so list may point into them
+	LruList<MeshData> mesh_lru;
+	size_t            mesh_bytes = 0;
+	Meshes            meshes;
+	// reused between remeshes, too big for stack
+	ChunkSnapshot snapshot;
+	// mesher output before it is copied into exactly sized cache entry
+	Vertices  mesh_vertices;
+	Indices   mesh_indices;
+	MeshStats mesh_stats;
+	bool      flat_quads_counted;
 
 	size_t frame_count;
 
@@ -56,12 +91,17 @@ private:
 	generate_mesh_data( const Chunk& );
 
 	void
-	upload_mesh( const MeshData& );
+	reset_if_need( const Vertices&, const Indices& );
 
 	void
-	reset_if_need( const Vertices&, const Indices& );
+	erase_mesh_data( MeshData& );
+
+	// drops least recently drawn meshes while cache is over budget
+	void
+	evict_meshes();
 
 public:
+	// nullptr device keeps meshes in host memory, nothing can be drawn
 	void
 	init( const struct ft_device* );
 
@@ -72,30 +112,47 @@ public:
 	push_chunk( const Chunk& chunk );
 
 	void
-	push_chunks( const std::list<Chunk*>& chunks );
+	push_chunks( const std::vector<Chunk*>& chunks );
+
+	// draws mesh which is not cached here, like far terrain
+	void
+	push_mesh( const Vertices& vertices, const Indices& indices );
+
+	// brings cached mesh up to date without drawing it
+	void
+	remesh_chunk( const Chunk& chunk );
 
 	void
 	pop_chunk();
 
+	// cached mesh of a chunk which was unloaded or emptied
+	void
+	drop_chunk( const glm::ivec3& chunk_position );
+
+	size_t
+	get_cache_bytes() const
+	{
+		return mesh_bytes;
+	}
+
+	const MeshStats&
+	get_mesh_stats() const
+	{
+		return mesh_stats;
+	}
+
+	// compares remeshes against merging without ambient occlusion, slows
+	// every remesh down by a fifth
+	void
+	set_flat_quads_counted( bool counted )
+	{
+		flat_quads_counted = counted;
+	}
+
 	void
 	reset()
 	{
-		if ( ( frame_count % 10 ) == 0 )
-		{
-			bool erase_something = false;
-			for ( auto it = mesh_data_map.begin(); it != mesh_data_map.end(); )
-			{
-				if ( frame_count - it->second.last_access_frame > 10 )
-				{
-					it              = mesh_data_map.erase( it );
-					erase_something = true;
-				}
-				else
-				{
-					it++;
-				}
-			}
-		}
+		evict_meshes();
 		vertex_buffer.offset = 0;
 		index_buffer.offset  = 0;
 		meshes.clear();
@@ -0,0 +1,461 @@
+#include <cmath>
+#include "noise.hpp"
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#define VK_CRAFT_NOISE_AVX2
+#elif defined( __SSE4_1__ )
+#include <smmintrin.h>
+#define VK_CRAFT_NOISE_SSE4
+#endif
+
+// one sample per lane, each glm vector component becomes its own Lanes
+#if defined( VK_CRAFT_NOISE_AVX2 )
+
+struct Lanes
+{
+	static constexpr uint32_t WIDTH = 8;
+	__m256                    v;
+};
+
+static inline Lanes
+lanes( float f )
+{
+	return { _mm256_set1_ps( f ) };
+}
+
+static inline Lanes
+load( const float* p )
+{
+	return { _mm256_loadu_ps( p ) };
+}
+
+static inline void
+store( float* p, Lanes a )
+{
+	_mm256_storeu_ps( p, a.v );
+}
+
+static inline Lanes
+operator+( Lanes a, Lanes b )
+{
+	return { _mm256_add_ps( a.v, b.v ) };
+}
+
+static inline Lanes
+operator-( Lanes a, Lanes b )
+{
+	return { _mm256_sub_ps( a.v, b.v ) };
+}
+
+static inline Lanes
+operator*( Lanes a, Lanes b )
+{
+	return { _mm256_mul_ps( a.v, b.v ) };
+}
+
+static inline Lanes
+operator/( Lanes a, Lanes b )
+{
+	return { _mm256_div_ps( a.v, b.v ) };
+}
+
+static inline Lanes
+floor( Lanes a )
+{
+	return { _mm256_floor_ps( a.v ) };
+}
+
+static inline Lanes
+abs( Lanes a )
+{
+	return { _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a.v ) };
+}
+
+// glm::step, x < edge ? 0 : 1
+static inline Lanes
+step( Lanes edge, Lanes x )
+{
+	return { _mm256_and_ps( _mm256_cmp_ps( x.v, edge.v, _CMP_GE_OQ ),
+	                        _mm256_set1_ps( 1.0f ) ) };
+}
+
+#elif defined( VK_CRAFT_NOISE_SSE4 )
+
+struct Lanes
+{
+	static constexpr uint32_t WIDTH = 4;
+	__m128                    v;
+};
+
+static inline Lanes
+lanes( float f )
+{
+	return { _mm_set1_ps( f ) };
+}
+
+static inline Lanes
+load( const float* p )
+{
+	return { _mm_loadu_ps( p ) };
+}
+
+static inline void
+store( float* p, Lanes a )
+{
+	_mm_storeu_ps( p, a.v );
+}
+
+static inline Lanes
+operator+( Lanes a, Lanes b )
+{
+	return { _mm_add_ps( a.v, b.v ) };
+}
+
+static inline Lanes
+operator-( Lanes a, Lanes b )
+{
+	return { _mm_sub_ps( a.v, b.v ) };
+}
+
+static inline Lanes
+operator*( Lanes a, Lanes b )
+{
+	return { _mm_mul_ps( a.v, b.v ) };
+}
+
+static inline Lanes
+operator/( Lanes a, Lanes b )
+{
+	return { _mm_div_ps( a.v, b.v ) };
+}
+
+static inline Lanes
+floor( Lanes a )
+{
+	return { _mm_floor_ps( a.v ) };
+}
+
+static inline Lanes
+abs( Lanes a )
+{
+	return { _mm_andnot_ps( _mm_set1_ps( -0.0f ), a.v ) };
+}
+
+static inline Lanes
+step( Lanes edge, Lanes x )
+{
+	return { _mm_and_ps( _mm_cmpge_ps( x.v, edge.v ), _mm_set1_ps( 1.0f ) ) };
+}
+
+#else
+
+struct Lanes
+{
+	static constexpr uint32_t WIDTH = 1;
+	float                     v;
+};
+
+static inline Lanes
+lanes( float f )
+{
+	return { f };
+}
+
+static inline Lanes
+load( const float* p )
+{
+	return { *p };
+}
+
+static inline void
+store( float* p, Lanes a )
+{
+	*p = a.v;
+}
+
+static inline Lanes
+operator+( Lanes a, Lanes b )
+{
+	return { a.v + b.v };
+}
+
+static inline Lanes
+operator-( Lanes a, Lanes b )
+{
+	return { a.v - b.v };
+}
+
+static inline Lanes
+operator*( Lanes a, Lanes b )
+{
+	return { a.v * b.v };
+}
+
+static inline Lanes
+operator/( Lanes a, Lanes b )
+{
+	return { a.v / b.v };
+}
+
+static inline Lanes
+floor( Lanes a )
+{
+	return { std::floor( a.v ) };
+}
+
+static inline Lanes
+abs( Lanes a )
+{
+	return { std::abs( a.v ) };
+}
+
+static inline Lanes
+step( Lanes edge, Lanes x )
+{
+	return { x.v < edge.v ? 0.0f : 1.0f };
+}
+
+#endif
+
+static inline Lanes
+fract( Lanes a )
+{
+	return a - floor( a );
+}
+
+static inline Lanes
+mod289( Lanes a )
+{
+	return a - floor( a * lanes( 1.0f / 289.0f ) ) * lanes( 289.0f );
+}
+
+static inline Lanes
+permute( Lanes a )
+{
+	return mod289( ( ( a * lanes( 34.0f ) ) + lanes( 1.0f ) ) * a );
+}
+
+static inline Lanes
+taylor_inv_sqrt( Lanes r )
+{
+	return lanes( 1.79284291400159f ) - lanes( 0.85373472095314f ) * r;
+}
+
+static inline Lanes
+fade( Lanes t )
+{
+	return ( t * t * t ) *
+	       ( t * ( t * lanes( 6.0f ) - lanes( 15.0f ) ) + lanes( 10.0f ) );
+}
+
+static inline Lanes
+mix( Lanes a, Lanes b, Lanes t )
+{
+	return a * ( lanes( 1.0f ) - t ) + b * t;
+}
+
+// gradient of 2d corner hash dotted with offset to that corner
+static inline Lanes
+gradient_2d( Lanes hash, Lanes fx, Lanes fy )
+{
+	Lanes gx = lanes( 2.0f ) * fract( hash / lanes( 41.0f ) ) - lanes( 1.0f );
+	Lanes gy = abs( gx ) - lanes( 0.5f );
+	Lanes tx = floor( gx + lanes( 0.5f ) );
+	gx       = gx - tx;
+
+	Lanes norm = taylor_inv_sqrt( gx * gx + gy * gy );
+	gx         = gx * norm;
+	gy         = gy * norm;
+
+	return gx * fx + gy * fy;
+}
+
+static inline Lanes
+gradient_3d( Lanes hash, Lanes fx, Lanes fy, Lanes fz )
+{
+	Lanes gx = hash * lanes( float( 1.0 / 7.0 ) );
+	Lanes gy =
+	    fract( floor( gx ) * lanes( float( 1.0 / 7.0 ) ) ) - lanes( 0.5f );
+	gx       = fract( gx );
+	Lanes gz = lanes( 0.5f ) - abs( gx ) - abs( gy );
+	Lanes sz = step( gz, lanes( 0.0f ) );
+	gx       = gx - sz * ( step( lanes( 0.0f ), gx ) - lanes( 0.5f ) );
+	gy       = gy - sz * ( step( lanes( 0.0f ), gy ) - lanes( 0.5f ) );
+
+	Lanes norm = taylor_inv_sqrt( gx * gx + gy * gy + gz * gz );
+	gx         = gx * norm;
+	gy         = gy * norm;
+	gz         = gz * norm;
+
+	return gx * fx + gy * fy + gz * fz;
+}
+
+// glm::perlin( vec2 )
+static inline Lanes
+perlin( Lanes x, Lanes y )
+{
+	Lanes x0 = floor( x );
+	Lanes y0 = floor( y );
+	Lanes x1 = x0 + lanes( 1.0f );
+	Lanes y1 = y0 + lanes( 1.0f );
+
+	Lanes fx0 = fract( x );
+	Lanes fy0 = fract( y );
+	Lanes fx1 = fx0 - lanes( 1.0f );
+	Lanes fy1 = fy0 - lanes( 1.0f );
+
+	// glm 2d version wraps with glm::mod here, not mod289
+	x0 = x0 - lanes( 289.0f ) * floor( x0 / lanes( 289.0f ) );
+	y0 = y0 - lanes( 289.0f ) * floor( y0 / lanes( 289.0f ) );
+	x1 = x1 - lanes( 289.0f ) * floor( x1 / lanes( 289.0f ) );
+	y1 = y1 - lanes( 289.0f ) * floor( y1 / lanes( 289.0f ) );
+
+	Lanes px0 = permute( x0 );
+	Lanes px1 = permute( x1 );
+
+	Lanes n00 = gradient_2d( permute( px0 + y0 ), fx0, fy0 );
+	Lanes n10 = gradient_2d( permute( px1 + y0 ), fx1, fy0 );
+	Lanes n01 = gradient_2d( permute( px0 + y1 ), fx0, fy1 );
+	Lanes n11 = gradient_2d( permute( px1 + y1 ), fx1, fy1 );
+
+	Lanes fade_x = fade( fx0 );
+	Lanes fade_y = fade( fy0 );
+
+	Lanes n_x0 = mix( n00, n10, fade_x );
+	Lanes n_x1 = mix( n01, n11, fade_x );
+
+	return lanes( 2.3f ) * mix( n_x0, n_x1, fade_y );
+}
+
+// glm::perlin( vec3 )
+static inline Lanes
+perlin( Lanes x, Lanes y, Lanes z )
+{
+	Lanes x0 = floor( x );
+	Lanes y0 = floor( y );
+	Lanes z0 = floor( z );
+	Lanes x1 = mod289( x0 + lanes( 1.0f ) );
+	Lanes y1 = mod289( y0 + lanes( 1.0f ) );
+	Lanes z1 = mod289( z0 + lanes( 1.0f ) );
+	x0       = mod289( x0 );
+	y0       = mod289( y0 );
+	z0       = mod289( z0 );
+
+	Lanes fx0 = fract( x );
+	Lanes fy0 = fract( y );
+	Lanes fz0 = fract( z );
+	Lanes fx1 = fx0 - lanes( 1.0f );
+	Lanes fy1 = fy0 - lanes( 1.0f );
+	Lanes fz1 = fz0 - lanes( 1.0f );
+
+	Lanes px0 = permute( x0 );
+	Lanes px1 = permute( x1 );
+
+	Lanes h00 = permute( px0 + y0 );
+	Lanes h10 = permute( px1 + y0 );
+	Lanes h01 = permute( px0 + y1 );
+	Lanes h11 = permute( px1 + y1 );
+
+	Lanes n000 = gradient_3d( permute( h00 + z0 ), fx0, fy0, fz0 );
+	Lanes n100 = gradient_3d( permute( h10 + z0 ), fx1, fy0, fz0 );
+	Lanes n010 = gradient_3d( permute( h01 + z0 ), fx0, fy1, fz0 );
+	Lanes n110 = gradient_3d( permute( h11 + z0 ), fx1, fy1, fz0 );
+	Lanes n001 = gradient_3d( permute( h00 + z1 ), fx0, fy0, fz1 );
+	Lanes n101 = gradient_3d( permute( h10 + z1 ), fx1, fy0, fz1 );
+	Lanes n011 = gradient_3d( permute( h01 + z1 ), fx0, fy1, fz1 );
+	Lanes n111 = gradient_3d( permute( h11 + z1 ), fx1, fy1, fz1 );
+
+	Lanes fade_x = fade( fx0 );
+	Lanes fade_y = fade( fy0 );
+	Lanes fade_z = fade( fz0 );
+
+	Lanes n00 = mix( n000, n001, fade_z );
+	Lanes n10 = mix( n100, n101, fade_z );
+	Lanes n01 = mix( n010, n011, fade_z );
+	Lanes n11 = mix( n110, n111, fade_z );
+
+	Lanes n0 = mix( n00, n01, fade_y );
+	Lanes n1 = mix( n10, n11, fade_y );
+
+	return lanes( 2.2f ) * mix( n0, n1, fade_x );
+}
+
+void
+noise_batch( const float* x,
+             const float* y,
+             const float* z,
+             float*       out,
+             size_t       count )
+{
+	size_t i = 0;
+
+	for ( ; i + Lanes::WIDTH <= count; i += Lanes::WIDTH )
+	{
+		store( out + i, perlin( load( x + i ), load( y + i ), load( z + i ) ) );
+	}
+
+	if ( i == count )
+	{
+		return;
+	}
+
+	// tail goes through one padded batch
+	float tail_x[ Lanes::WIDTH ] = {};
+	float tail_y[ Lanes::WIDTH ] = {};
+	float tail_z[ Lanes::WIDTH ] = {};
+	float tail[ Lanes::WIDTH ];
+
+	for ( size_t j = 0; i + j < count; j++ )
+	{
+		tail_x[ j ] = x[ i + j ];
+		tail_y[ j ] = y[ i + j ];
+		tail_z[ j ] = z[ i + j ];
+	}
+
+	store( tail, perlin( load( tail_x ), load( tail_y ), load( tail_z ) ) );
+
+	for ( size_t j = 0; i + j < count; j++ )
+	{
+		out[ i + j ] = tail[ j ];
+	}
+}
+
+void
+noise_batch( const float* x, const float* y, float* out, size_t count )
+{
+	size_t i = 0;
+
+	for ( ; i + Lanes::WIDTH <= count; i += Lanes::WIDTH )
+	{
+		store( out + i, perlin( load( x + i ), load( y + i ) ) );
+	}
+
+	if ( i == count )
+	{
+		return;
+	}
+
+	float tail_x[ Lanes::WIDTH ] = {};
+	float tail_y[ Lanes::WIDTH ] = {};
+	float tail[ Lanes::WIDTH ];
+
+	for ( size_t j = 0; i + j < count; j++ )
+	{
+		tail_x[ j ] = x[ i + j ];
+		tail_y[ j ] = y[ i + j ];
+	}
+
+	store( tail, perlin( load( tail_x ), load( tail_y ) ) );
+
+	for ( size_t j = 0; i + j < count; j++ )
+	{
+		out[ i + j ] = tail[ j ];
+	}
+}
+
+uint32_t
+noise_lane_count()
+{
+	return Lanes::WIDTH;
+}
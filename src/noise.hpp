@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// vectorized ports of glm::perlin, lanes follow glm operation order so
+// results match scalar glm bit for bit as long as compiler does not
+// contract glm expressions into fma. uses avx2 or sse4.1 when enabled at
+// compile time, plain floats otherwise
+
+// out[ i ] = perlin( vec3( x[ i ], y[ i ], z[ i ] ) )
+void
+noise_batch( const float* x,
+             const float* y,
+             const float* z,
+             float*       out,
+             size_t       count );
+
+// out[ i ] = perlin( vec2( x[ i ], y[ i ] ) )
+void
+noise_batch( const float* x, const float* y, float* out, size_t count );
+
+// lanes processed per call of the kernel, 8, 4 or 1
+uint32_t
+noise_lane_count();
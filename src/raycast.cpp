@@ -0,0 +1,187 @@
+#include <algorithm>
+#include "raycast.hpp"
+
+static inline glm::ivec3
+voxel_to_chunk( const glm::ivec3 voxel )
+{
+	return { voxel.x / CHUNK_SIZE - ( voxel.x % CHUNK_SIZE < 0 ),
+	         voxel.y / CHUNK_SIZE - ( voxel.y % CHUNK_SIZE < 0 ),
+	         voxel.z / CHUNK_SIZE - ( voxel.z % CHUNK_SIZE < 0 ) };
+}
+
+// face of hit voxel ray went through, COUNT when ray started inside it
+static inline Face::Type
+hit_face( int stepped_index, int step_x, int step_y, int step_z )
+{
+	switch ( stepped_index )
+	{
+	case 0: return step_x > 0 ? Face::LEFT : Face::RIGHT;
+	case 1: return step_y > 0 ? Face::BOTTOM : Face::TOP;
+	case 2: return step_z > 0 ? Face::BACK : Face::FRONT;
+	default: return Face::COUNT;
+	}
+}
+
+static inline RaycastResult
+hit_result( const glm::ivec3 voxel,
+            int              stepped_index,
+            const glm::ivec3 step,
+            float            t_enter,
+            float            range )
+{
+	RaycastResult res;
+	res.end    = voxel;
+	res.norm.x = res.norm.y = res.norm.z = 0.0f;
+	if ( stepped_index >= 0 )
+		res.norm[ stepped_index ] = -step[ stepped_index ];
+	res.distance = t_enter * range;
+	res.face     = hit_face( stepped_index, step.x, step.y, step.z );
+	return res;
+}
+
+std::optional<RaycastResult>
+raycast( const ChunkManager& manager,
+         const glm::vec3&    start_point,
+         const glm::vec3&    direction,
+         float               range )
+{
+	auto       n_direction = normalize( direction );
+	auto       end_point   = start_point + n_direction * range;
+	glm::ivec3 voxel;
+	to_voxel_position( voxel, start_point );
+
+	// +1, -1, or 0
+	glm::ivec3 step;
+	// parameter between two planes of an axis, 0 to 1 is whole range
+	glm::vec3 t_delta;
+
+	for ( int axis = 0; axis < 3; axis++ )
+	{
+		float d         = n_direction[ axis ];
+		float length    = end_point[ axis ] - start_point[ axis ];
+		step[ axis ]    = ( d > 0 ) ? 1 : ( ( d < 0 ) ? -1 : 0 );
+		t_delta[ axis ] = ( step[ axis ] != 0 )
+		                      ? fmin( step[ axis ] / length, FLT_MAX )
+		                      : FLT_MAX;
+	}
+
+	// where ray leaves cell starting at low along axis. computed from the
+	// plane instead of summed up step by step, so skipping a cell lands on
+	// same value as walking through it voxel by voxel
+	auto cell_exit = [ & ]( int axis, int32_t low, int32_t size )
+	{
+		if ( step[ axis ] == 0 )
+		{
+			return FLT_MAX;
+		}
+
+		int32_t plane = step[ axis ] > 0 ? low + size : low;
+		return ( plane - start_point[ axis ] ) * step[ axis ] * t_delta[ axis ];
+	};
+
+	// voxels walked, skipped ones included
+	int32_t steps         = 0;
+	int     stepped_index = -1;
+	// where ray entered current voxel, 0 to 1 along whole range
+	float t_enter = 0.0f;
+
+	glm::ivec3   chunk_position = voxel_to_chunk( voxel );
+	const Chunk* chunk          = manager.find_chunk( chunk_position );
+
+	while ( steps + 1 < range * 3 )
+	{
+		glm::ivec3 voxel_chunk = voxel_to_chunk( voxel );
+
+		if ( voxel_chunk != chunk_position )
+		{
+			chunk_position = voxel_chunk;
+			chunk          = manager.find_chunk( chunk_position );
+		}
+
+		glm::ivec3 local = voxel - chunk_position * CHUNK_SIZE;
+
+		// unloaded or AIR chunks and AIR bricks are crossed in one step
+		int32_t size = 1;
+
+		if ( chunk == nullptr || chunk->is_empty() )
+		{
+			size = CHUNK_SIZE;
+		}
+		else if ( chunk->is_brick_empty( local ) )
+		{
+			size = Chunk::BRICK_SIZE;
+		}
+
+		glm::ivec3 low = voxel - local % size;
+		glm::vec3  t_exit( cell_exit( 0, low.x, size ),
+		                   cell_exit( 1, low.y, size ),
+		                   cell_exit( 2, low.z, size ) );
+
+		// ties go to higher axis, same order voxel stepping always used
+		int axis = 0;
+		if ( t_exit.y <= t_exit[ axis ] )
+			axis = 1;
+		if ( t_exit.z <= t_exit[ axis ] )
+			axis = 2;
+
+		bool is_last = t_exit[ axis ] > 1.0f;
+
+		// voxel ray ends in is not tested, unless ray starts there too
+		if ( size == 1 && ( !is_last || stepped_index < 0 ) &&
+		     !chunk->is_air( local ) )
+		{
+			return hit_result( voxel, stepped_index, step, t_enter, range );
+		}
+
+		if ( is_last )
+			break;
+
+		// other axes cross their planes inside cell before it is left, or
+		// at same time when they would be stepped first. a single voxel
+		// has none of them
+		for ( int other = 0; other < 3 && size > 1; other++ )
+		{
+			while ( other != axis )
+			{
+				float t    = cell_exit( other, voxel[ other ], 1 );
+				bool  tied = t == t_exit[ axis ] && other > axis;
+
+				if ( t >= t_exit[ axis ] && !tied )
+					break;
+
+				voxel[ other ] += step[ other ];
+				steps++;
+			}
+		}
+
+		int32_t next = step[ axis ] > 0 ? low[ axis ] + size : low[ axis ] - 1;
+		steps += std::abs( next - voxel[ axis ] );
+		voxel[ axis ] = next;
+		t_enter       = t_exit[ axis ];
+		stepped_index = axis;
+	}
+	return {};
+}
+
+void
+raycast_batch( const ChunkManager&                        manager,
+               const std::vector<Ray>&                    rays,
+               std::vector<std::optional<RaycastResult>>& results )
+{
+	results.resize( rays.size() );
+
+	// chunk manager is only read, it must not change until batch is done
+	manager.get_raycast_workers().run(
+	    rays.size(),
+	    RAYCAST_RAYS_PER_THREAD,
+	    [ & ]( size_t begin, size_t end )
+	    {
+		    for ( size_t i = begin; i < end; i++ )
+		    {
+			    results[ i ] = raycast( manager,
+			                            rays[ i ].origin,
+			                            rays[ i ].direction,
+			                            rays[ i ].range );
+		    }
+	    } );
+}
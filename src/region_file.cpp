@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <cstring>
+#if defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "region_file.hpp"
+
+RegionFile::~RegionFile()
+{
+	close();
+}
+
+#if defined( _WIN32 )
+
+bool
+RegionFile::open( const std::string& path )
+{
+	file = CreateFileA( path.c_str(),
+	                    GENERIC_READ | GENERIC_WRITE,
+	                    FILE_SHARE_READ,
+	                    nullptr,
+	                    OPEN_ALWAYS,
+	                    FILE_ATTRIBUTE_NORMAL,
+	                    nullptr );
+
+	if ( file == INVALID_HANDLE_VALUE )
+	{
+		file = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	GetFileSizeEx( file, &size );
+	file_size = size_t( size.QuadPart );
+
+	return open_header();
+}
+
+void
+RegionFile::close()
+{
+	unmap();
+
+	if ( file != nullptr )
+	{
+		CloseHandle( file );
+		file = nullptr;
+	}
+}
+
+bool
+RegionFile::map()
+{
+	if ( mapped != nullptr )
+	{
+		return true;
+	}
+
+	mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+
+	if ( mapping == nullptr )
+	{
+		return false;
+	}
+
+	mapped = static_cast<const uint8_t*>(
+	    MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) );
+	mapped_size = file_size;
+
+	return mapped != nullptr;
+}
+
+void
+RegionFile::unmap()
+{
+	if ( mapped != nullptr )
+	{
+		UnmapViewOfFile( mapped );
+		mapped = nullptr;
+	}
+
+	if ( mapping != nullptr )
+	{
+		CloseHandle( mapping );
+		mapping = nullptr;
+	}
+
+	mapped_size = 0;
+}
+
+bool
+RegionFile::write_at( size_t offset, const void* data, size_t size )
+{
+	OVERLAPPED overlapped = {};
+	overlapped.Offset     = DWORD( offset );
+	overlapped.OffsetHigh = DWORD( uint64_t( offset ) >> 32 );
+
+	DWORD written = 0;
+	if ( !WriteFile( file, data, DWORD( size ), &written, &overlapped ) ||
+	     written != size )
+	{
+		return false;
+	}
+
+	file_size = std::max( file_size, offset + size );
+	return true;
+}
+
+bool
+RegionFile::sync()
+{
+	return FlushFileBuffers( file ) != 0;
+}
+
+#else
+
+bool
+RegionFile::open( const std::string& path )
+{
+	file = ::open( path.c_str(), O_RDWR | O_CREAT, 0644 );
+
+	if ( file < 0 )
+	{
+		return false;
+	}
+
+	struct stat info;
+	fstat( file, &info );
+	file_size = size_t( info.st_size );
+
+	return open_header();
+}
+
+void
+RegionFile::close()
+{
+	unmap();
+
+	if ( file >= 0 )
+	{
+		::close( file );
+		file = -1;
+	}
+}
+
+bool
+RegionFile::map()
+{
+	if ( mapped != nullptr )
+	{
+		return true;
+	}
+
+	void* memory =
+	    mmap( nullptr, file_size, PROT_READ, MAP_SHARED, file, 0 );
+
+	if ( memory == MAP_FAILED )
+	{
+		return false;
+	}
+
+	mapped      = static_cast<const uint8_t*>( memory );
+	mapped_size = file_size;
+
+	return true;
+}
+
+void
+RegionFile::unmap()
+{
+	if ( mapped != nullptr )
+	{
+		munmap( const_cast<uint8_t*>( mapped ), mapped_size );
+		mapped = nullptr;
+	}
+
+	mapped_size = 0;
+}
+
+bool
+RegionFile::write_at( size_t offset, const void* data, size_t size )
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>( data );
+
+	while ( size != 0 )
+	{
+		ssize_t written = pwrite( file, bytes, size, off_t( offset ) );
+
+		if ( written <= 0 )
+		{
+			return false;
+		}
+
+		bytes += written;
+		offset += size_t( written );
+		size -= size_t( written );
+		file_size = std::max( file_size, offset );
+	}
+
+	return true;
+}
+
+bool
+RegionFile::sync()
+{
+	return fdatasync( file ) == 0;
+}
+
+#endif
+
+bool
+RegionFile::open_header()
+{
+	entries.fill( {} );
+
+	if ( file_size < HEADER_SECTORS * SECTOR_SIZE )
+	{
+		// new file, reserve whole header so payloads never overlap it
+		std::vector<uint8_t> header( HEADER_SECTORS * SECTOR_SIZE, 0 );
+		if ( !write_at( 0, header.data(), header.size() ) )
+		{
+			return false;
+		}
+	}
+	else
+	{
+		if ( !map() )
+		{
+			return false;
+		}
+		memcpy( entries.data(), mapped, sizeof( entries ) );
+	}
+
+	used_sectors.assign( ( file_size + SECTOR_SIZE - 1 ) / SECTOR_SIZE,
+	                     false );
+	std::fill_n( used_sectors.begin(), HEADER_SECTORS, true );
+
+	for ( Entry& entry : entries )
+	{
+		// drop entries pointing past end of a truncated file
+		if ( entry.sector < HEADER_SECTORS ||
+		     size_t( entry.sector ) + entry.sector_count >
+		         used_sectors.size() )
+		{
+			entry = {};
+			continue;
+		}
+
+		std::fill_n( used_sectors.begin() + entry.sector,
+		             entry.sector_count,
+		             true );
+	}
+
+	return true;
+}
+
+uint32_t
+RegionFile::allocate( uint32_t sector_count )
+{
+	uint32_t run = 0;
+
+	for ( uint32_t i = HEADER_SECTORS; i < used_sectors.size(); i++ )
+	{
+		run = used_sectors[ i ] ? 0 : run + 1;
+
+		if ( run == sector_count )
+		{
+			return i + 1 - sector_count;
+		}
+	}
+
+	// no hole large enough, append behind trailing free sectors
+	uint32_t sector = uint32_t( used_sectors.size() ) - run;
+	used_sectors.resize( sector + sector_count, false );
+
+	return sector;
+}
+
+bool
+RegionFile::read( const glm::ivec2 local, std::vector<uint8_t>& payload )
+{
+	const Entry& entry = entries[ local.x + REGION_SIZE * local.y ];
+
+	if ( entry.sector == 0 || !map() )
+	{
+		return false;
+	}
+
+	size_t   offset = size_t( entry.sector ) * SECTOR_SIZE;
+	uint32_t size   = 0;
+
+	if ( offset + sizeof( size ) > mapped_size )
+	{
+		return false;
+	}
+
+	memcpy( &size, mapped + offset, sizeof( size ) );
+	offset += sizeof( size );
+
+	if ( offset + size > mapped_size )
+	{
+		return false;
+	}
+
+	payload.assign( mapped + offset, mapped + offset + size );
+
+	return true;
+}
+
+bool
+RegionFile::write( const glm::ivec2 local, const std::vector<uint8_t>& payload )
+{
+	uint32_t index        = local.x + REGION_SIZE * local.y;
+	Entry    old_entry    = entries[ index ];
+	uint32_t size         = uint32_t( payload.size() );
+	uint32_t sector_count = uint32_t(
+	    ( sizeof( size ) + size + SECTOR_SIZE - 1 ) / SECTOR_SIZE );
+
+	// old sectors stay in use until header points elsewhere, so payload
+	// never lands on the one header still refers to
+	Entry entry;
+	entry.sector       = allocate( sector_count );
+	entry.sector_count = sector_count;
+
+	std::fill_n( used_sectors.begin() + entry.sector, sector_count, true );
+
+	// mapping does not cover appended sectors, map again on next read
+	unmap();
+
+	size_t offset = size_t( entry.sector ) * SECTOR_SIZE;
+
+	// payload has to be on disk before header entry points at it
+	if ( !write_at( offset, &size, sizeof( size ) ) ||
+	     !write_at( offset + sizeof( size ), payload.data(), size ) ||
+	     !sync() )
+	{
+		// header still refers to previous payload
+		std::fill_n(
+		    used_sectors.begin() + entry.sector, sector_count, false );
+		return false;
+	}
+
+	entries[ index ] = entry;
+
+	// header on disk may refer to either payload now, both stay claimed
+	// until reopen rebuilds sector usage from header
+	if ( !write_at( index * sizeof( Entry ), &entry, sizeof( Entry ) ) ||
+	     !sync() )
+	{
+		return false;
+	}
+
+	if ( old_entry.sector != 0 )
+	{
+		std::fill_n( used_sectors.begin() + old_entry.sector,
+		             old_entry.sector_count,
+		             false );
+	}
+
+	return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// one file per REGION_SIZE x REGION_SIZE columns. file starts with a table
+// of sector ranges, one per column, followed by 4 KiB sectors holding
+// column payloads. rewrites go to free sectors, payload is synced before
+// header points to it and old sectors are released only once header is
+// synced, failed write keeps previous version. freed sectors are reused
+// first fit. reads go through a read only mapping
+// of the whole file, not thread safe, caller serializes access
+class RegionFile
+{
+public:
+	static constexpr int32_t REGION_SIZE  = 32;
+	static constexpr int32_t COLUMN_COUNT = REGION_SIZE * REGION_SIZE;
+	static constexpr size_t  SECTOR_SIZE  = 4096;
+
+private:
+	struct Entry
+	{
+		// 0 means column was never written
+		uint32_t sector;
+		uint32_t sector_count;
+	};
+
+	static constexpr size_t HEADER_SECTORS =
+	    ( sizeof( Entry ) * COLUMN_COUNT + SECTOR_SIZE - 1 ) / SECTOR_SIZE;
+
+#if defined( _WIN32 )
+	void* file    = nullptr;
+	void* mapping = nullptr;
+#else
+	int file = -1;
+#endif
+	const uint8_t* mapped      = nullptr;
+	size_t         mapped_size = 0;
+	size_t         file_size   = 0;
+
+	std::array<Entry, COLUMN_COUNT> entries;
+	std::vector<bool>               used_sectors;
+
+	// reads or writes header table and builds sector usage
+	bool
+	open_header();
+
+	bool
+	map();
+
+	void
+	unmap();
+
+	bool
+	write_at( size_t offset, const void* data, size_t size );
+
+	// waits until written data reaches disk
+	bool
+	sync();
+
+	uint32_t
+	allocate( uint32_t sector_count );
+
+public:
+	~RegionFile();
+
+	// creates file when it does not exist
+	bool
+	open( const std::string& path );
+
+	void
+	close();
+
+	// local is column position inside region. false if not stored
+	bool
+	read( const glm::ivec2 local, std::vector<uint8_t>& payload );
+
+	bool
+	write( const glm::ivec2 local, const std::vector<uint8_t>& payload );
+};
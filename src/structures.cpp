@@ -0,0 +1,226 @@
+#include <cstdlib>
+#include <vector>
+#include "chunk_column.hpp"
+#include "chunk_pool.hpp"
+#include "heightmap_cache.hpp"
+#include "structures.hpp"
+
+// every column rolls this many times for a tree, rolls landing on grass
+// grow one with chance of biome they land in
+static constexpr int32_t TREE_ROLLS     = 4;
+static constexpr int32_t TREE_MIN_TRUNK = 4;
+static constexpr int32_t TREE_MAX_TRUNK = 6;
+// leaves reach this far from trunk, less than a column, so only direct
+// neighbors have trees reaching into a column
+static constexpr int32_t TREE_RADIUS = 2;
+// percent of rolls growing a tree
+static constexpr uint32_t TREE_CHANCES[ Biome::COUNT ] = { 8, 60, 0, 0, 0 };
+
+struct Tree
+{
+	// lowest trunk voxel, x and z local to column being placed
+	glm::ivec3 position;
+	int32_t    trunk;
+};
+
+static inline uint32_t
+next_random( uint32_t& state )
+{
+	state += 0x9e3779b9u;
+	return hash_bits( state );
+}
+
+// start of random stream of a column, same whichever column places it
+static inline uint32_t
+column_seed( const glm::ivec2& position )
+{
+	return hash_bits( get_world_seed() ^
+	                  hash_bits( uint32_t( position.x ) ^
+	                             hash_bits( uint32_t( position.y ) ) ) );
+}
+
+static inline uint32_t
+voxel_seed( const glm::ivec3& position )
+{
+	return hash_bits( column_seed( { position.x, position.z } ) ^
+	                  uint32_t( position.y ) );
+}
+
+// trees of column at offset from placed one which may reach into it
+static void
+collect_trees( const ChunkColumn& column,
+               const glm::ivec2&  offset,
+               const Heightmap&   heights,
+               HeightmapCache&    heightmap_cache,
+               std::vector<Tree>& trees )
+{
+	glm::ivec2 source = column.position + offset;
+	uint32_t   state  = column_seed( source );
+
+	// heightmap of neighbor is fetched only when one of its trees comes
+	// close enough
+	const Heightmap* source_heights = offset == glm::ivec2( 0 ) ? &heights
+	                                                            : nullptr;
+	Heightmap neighbor_heights;
+
+	for ( int32_t i = 0; i < TREE_ROLLS; i++ )
+	{
+		// all values are drawn before anything is skipped, so stream stays
+		// same for every column placing this one
+		int32_t x     = next_random( state ) % CHUNK_SIZE;
+		int32_t z     = next_random( state ) % CHUNK_SIZE;
+		int32_t trunk = TREE_MIN_TRUNK +
+		                next_random( state ) %
+		                    ( TREE_MAX_TRUNK - TREE_MIN_TRUNK + 1 );
+		uint32_t chance = next_random( state ) % 100;
+
+		glm::ivec2 local = glm::ivec2( x, z ) + offset * CHUNK_SIZE;
+
+		if ( local.x + TREE_RADIUS < 0 ||
+		     local.y + TREE_RADIUS < 0 ||
+		     local.x - TREE_RADIUS >= CHUNK_SIZE ||
+		     local.y - TREE_RADIUS >= CHUNK_SIZE )
+		{
+			continue;
+		}
+
+		if ( source_heights == nullptr )
+		{
+			heightmap_cache.get( source, neighbor_heights );
+			source_heights = &neighbor_heights;
+		}
+
+		int32_t     index  = x + CHUNK_SIZE * z;
+		int32_t     height = source_heights->heights[ index ];
+		Biome::Type biome  = source_heights->biomes[ index ];
+
+		// trees on surface opened by a cave would float
+		if ( chance >= TREE_CHANCES[ biome ] ||
+		     column_voxel( height - 1, height, biome ) != Voxel::GRASS ||
+		     height + trunk + 1 >= WORLD_HEIGHT ||
+		     is_cave_voxel( glm::ivec3( source.x * CHUNK_SIZE + x,
+		                                height - 1,
+		                                source.y * CHUNK_SIZE + z ) ) )
+		{
+			continue;
+		}
+
+		trees.push_back( Tree { { local.x, height, local.y }, trunk } );
+	}
+}
+
+// x and z local to column, y is world height. sections are allocated as
+// needed like in replay of player edits
+static void
+set_column_voxel( ChunkColumn&      column,
+                  const glm::ivec3& position,
+                  Voxel::Type       voxel,
+                  ChunkManager*     chunk_manager,
+                  ChunkPool&        chunk_pool )
+{
+	int32_t y     = position.y / CHUNK_SIZE;
+	Chunk*& chunk = column.sections[ y ];
+
+	if ( chunk == nullptr )
+	{
+		chunk = chunk_pool.acquire();
+		chunk->attach( glm::ivec3( column.position.x, y, column.position.y ),
+		               chunk_manager,
+		               &column );
+	}
+
+	chunk->set_voxel( { position.x, position.y % CHUNK_SIZE, position.z },
+	                  voxel );
+}
+
+static bool
+is_inside_column( const glm::ivec3& position )
+{
+	return position.x >= 0 && position.x < CHUNK_SIZE && position.z >= 0 &&
+	       position.z < CHUNK_SIZE;
+}
+
+void
+place_structures( ChunkColumn&     column,
+                  const Heightmap& heights,
+                  ChunkManager*    chunk_manager,
+                  ChunkPool&       chunk_pool,
+                  HeightmapCache&  heightmap_cache )
+{
+	std::vector<Tree> trees;
+
+	for ( int32_t z = -1; z <= 1; z++ )
+	{
+		for ( int32_t x = -1; x <= 1; x++ )
+		{
+			collect_trees(
+			    column, { x, z }, heights, heightmap_cache, trees );
+		}
+	}
+
+	glm::ivec3 origin( column.position.x * CHUNK_SIZE,
+	                   0,
+	                   column.position.y * CHUNK_SIZE );
+
+	// leaves of all trees go first and fill only AIR, trunks overwrite
+	// them, so overlapping trees look same whatever order they come in
+	for ( const Tree& tree : trees )
+	{
+		int32_t top = tree.position.y + tree.trunk;
+
+		for ( int32_t dy = -3; dy <= 0; dy++ )
+		{
+			int32_t radius = dy < -1 ? TREE_RADIUS : 1;
+
+			for ( int32_t dz = -radius; dz <= radius; dz++ )
+			{
+				for ( int32_t dx = -radius; dx <= radius; dx++ )
+				{
+					glm::ivec3 position( tree.position.x + dx,
+					                     top + dy,
+					                     tree.position.z + dz );
+
+					if ( !is_inside_column( position ) ||
+					     column.get_voxel( position ) != Voxel::AIR )
+					{
+						continue;
+					}
+
+					// corners are trimmed, always on top and by world
+					// position below, so both sides of border agree
+					bool corner =
+					    std::abs( dx ) == radius && std::abs( dz ) == radius;
+
+					if ( corner && ( dy == 0 ||
+					                 ( voxel_seed( position + origin ) & 1 ) ) )
+					{
+						continue;
+					}
+
+					set_column_voxel( column,
+					                  position,
+					                  Voxel::LEAVES,
+					                  chunk_manager,
+					                  chunk_pool );
+				}
+			}
+		}
+	}
+
+	for ( const Tree& tree : trees )
+	{
+		if ( !is_inside_column( tree.position ) )
+		{
+			continue;
+		}
+
+		for ( int32_t y = 0; y < tree.trunk; y++ )
+		{
+			set_column_voxel( column,
+			                  tree.position + glm::ivec3( 0, y, 0 ),
+			                  Voxel::WOOD,
+			                  chunk_manager,
+			                  chunk_pool );
+		}
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "chunk.hpp"
+
+class ChunkManager;
+class ChunkPool;
+class HeightmapCache;
+struct ChunkColumn;
+
+// structures standing on generated terrain, trees for now. where a column
+// places them depends only on its position and heightmap, so every column
+// places structures of its neighbors again and keeps voxels landing in
+// itself. writes across column borders wait for the column they land in,
+// columns still generate in any order on any worker and structures are
+// never cut off, not even when a neighbor unloads and generates again
+void
+place_structures( ChunkColumn&     column,
+                  const Heightmap& heights,
+                  ChunkManager*    chunk_manager,
+                  ChunkPool&       chunk_pool,
+                  HeightmapCache&  heightmap_cache );
@@ -0,0 +1,737 @@
+#include <algorithm>
+#include <cmath>
+#include "noise.hpp"
+#include "terrain.hpp"
+
+struct BiomeParameters
+{
+	// climate biome is strongest at
+	float temperature;
+	float humidity;
+	// mean surface height and how far relief swings around it
+	float base;
+	float amplitude;
+	// weight of detail noise against smooth relief
+	float roughness;
+};
+
+// climate of beach is unused, it takes over from any biome below
+// BEACH_HEIGHT
+static constexpr BiomeParameters BIOMES[ Biome::COUNT ] = {
+	{ 0.0f, -0.1f, 72.0f, 6.0f, 0.3f },
+	{ 0.05f, 0.3f, 74.0f, 10.0f, 0.5f },
+	{ 0.35f, -0.35f, 70.0f, 6.0f, 0.15f },
+	{ -0.3f, 0.05f, 92.0f, 40.0f, 1.0f },
+	{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+};
+
+// voxels of every biome by depth class, surface voxel, filler under it and
+// stone from FILLER_DEPTH below top
+static constexpr Voxel::Type DEPTH_VOXELS[ Biome::COUNT ][ 3 ] = {
+	{ Voxel::GRASS, Voxel::GROUND, Voxel::STONE },
+	{ Voxel::GRASS, Voxel::GROUND, Voxel::STONE },
+	{ Voxel::SAND, Voxel::SAND, Voxel::STONE },
+	{ Voxel::STONE, Voxel::STONE, Voxel::STONE },
+	{ Voxel::SAND, Voxel::SAND, Voxel::STONE },
+};
+
+static constexpr int32_t CLIMATE_BIOME_COUNT = Biome::BEACH;
+static constexpr int32_t BEACH_HEIGHT        = TERRAIN_BASE_HEIGHT + 5;
+static constexpr int32_t FILLER_DEPTH        = 4;
+// room above highest terrain for trees
+static constexpr int32_t MAX_TERRAIN_HEIGHT = WORLD_HEIGHT - 32;
+// keeps weight of biome finite at its own climate, larger values blend
+// wider borders
+static constexpr float BIOME_BLEND = 0.01f;
+
+enum Layer : uint32_t
+{
+	TEMPERATURE,
+	HUMIDITY,
+	// smooth hills of all biomes
+	RELIEF,
+	DETAIL,
+	LAYER_COUNT
+};
+
+struct NoiseLayer
+{
+	// voxels per noise lattice cell of first octave
+	float   scale;
+	int32_t octaves;
+	float   gain;
+};
+
+static constexpr NoiseLayer LAYERS[ LAYER_COUNT ] = {
+	{ 512.0f, 2, 0.5f },
+	{ 512.0f, 2, 0.5f },
+	{ 192.0f, 2, 0.5f },
+	{ 48.0f, 3, 0.5f },
+};
+
+// octaves are sampled on grids of voxels and interpolated in between.
+// grid spacing is largest power of two that still puts this many samples
+// in a lattice cell of the octave, interpolation stays far below a voxel
+// of height while wide octaves take a handful of samples per column
+static constexpr float SAMPLES_PER_CELL = 6.0f;
+
+// grid spacing for octave with cells of given size in voxels
+static constexpr int32_t
+sample_step( float cell )
+{
+	int32_t step = 1;
+
+	while ( step < CHUNK_SIZE && float( step * 2 ) * SAMPLES_PER_CELL <= cell )
+	{
+		step *= 2;
+	}
+
+	return step;
+}
+
+// grids cover column and first voxels of next columns, finest one has a
+// sample at every voxel
+static constexpr int32_t GRID_SIZE    = CHUNK_SIZE + 1;
+static constexpr int32_t GRID_SAMPLES = GRID_SIZE * GRID_SIZE;
+// climate and relief do not bend between points this far apart, biomes
+// are blended at them instead of at every voxel
+static constexpr int32_t BLEND_STEP = 4;
+static constexpr int32_t BLEND_SIZE = CHUNK_SIZE / BLEND_STEP + 1;
+// finest octave of detail decides its grid
+static constexpr int32_t DETAIL_STEP =
+    sample_step( LAYERS[ DETAIL ].scale /
+                 float( 1 << ( LAYERS[ DETAIL ].octaves - 1 ) ) );
+static constexpr int32_t DETAIL_SIZE = CHUNK_SIZE / DETAIL_STEP + 1;
+
+// tunnels run where both cave fields are near zero, density is sum of
+// their squares minus threshold and voxels with negative density are
+// carved. deeper thresholds give wider caves
+static constexpr int32_t CAVE_FIELDS            = 2;
+static constexpr float   CAVE_SCALE             = 48.0f;
+static constexpr float   CAVE_VERTICAL_SCALE    = 24.0f;
+static constexpr float   CAVE_THRESHOLD_DEEP    = 0.01f;
+static constexpr float   CAVE_THRESHOLD_SURFACE = 0.004f;
+// voxels at or below it are never carved, world keeps a floor
+static constexpr int32_t CAVE_FLOOR = 4;
+// voxels between density samples along every axis
+static constexpr int32_t CAVE_STEP    = 4;
+static constexpr int32_t CAVE_CELLS   = CHUNK_SIZE / CAVE_STEP;
+static constexpr int32_t CAVE_SIZE    = CAVE_CELLS + 1;
+static constexpr int32_t CAVE_SAMPLES = CAVE_SIZE * CAVE_SIZE * CAVE_SIZE;
+// interpolation weight of far corner for voxel at offset in cell
+static constexpr float CAVE_WEIGHTS[ CAVE_STEP ] = { 0.0f, 0.25f, 0.5f, 0.75f };
+
+static struct
+{
+	uint32_t  seed;
+	glm::vec2 offsets[ LAYER_COUNT ];
+	glm::vec3 cave_offsets[ CAVE_FIELDS ];
+} terrain;
+
+void
+init_terrain( uint32_t seed )
+{
+	terrain.seed = seed;
+
+	// noise repeats every 289 lattice cells, offsets spread over all of it
+	for ( uint32_t i = 0; i < LAYER_COUNT; i++ )
+	{
+		uint32_t bits = hash_bits( seed ^ hash_bits( i ) );
+		terrain.offsets[ i ] =
+		    glm::vec2( bits & 0xffff, bits >> 16 ) * ( 289.0f / 65536.0f );
+	}
+
+	for ( uint32_t i = 0; i < CAVE_FIELDS; i++ )
+	{
+		uint32_t bits = hash_bits( seed ^ hash_bits( LAYER_COUNT + i ) );
+		uint32_t more = hash_bits( bits );
+		terrain.cave_offsets[ i ] =
+		    glm::vec3( bits & 0xffff, bits >> 16, more & 0xffff ) *
+		    ( 289.0f / 65536.0f );
+	}
+}
+
+uint32_t
+get_world_seed()
+{
+	return terrain.seed;
+}
+
+// adds grid of samples source_step voxels apart to grid of samples step
+// voxels apart, interpolated in between. step divides source_step
+static void
+add_resampled( const float* source,
+               int32_t      source_step,
+               float*       grid,
+               int32_t      step )
+{
+	int32_t source_size = CHUNK_SIZE / source_step + 1;
+	int32_t size        = CHUNK_SIZE / step + 1;
+	int32_t cells[ GRID_SIZE ];
+	float   weights[ GRID_SIZE ];
+
+	for ( int32_t i = 0; i < size; i++ )
+	{
+		// last sample lies on far edge of last cell
+		cells[ i ]   = std::min( i * step / source_step, source_size - 2 );
+		weights[ i ] = float( i * step - cells[ i ] * source_step ) /
+		               float( source_step );
+	}
+
+	for ( int32_t j = 0; j < size; j++ )
+	{
+		const float* near = source + source_size * cells[ j ];
+		const float* far  = near + source_size;
+
+		for ( int32_t i = 0; i < size; i++ )
+		{
+			int32_t c = cells[ i ];
+			float   w = weights[ i ];
+			float   n = near[ c ] + ( near[ c + 1 ] - near[ c ] ) * w;
+			float   f = far[ c ] + ( far[ c + 1 ] - far[ c ] ) * w;
+
+			grid[ i + size * j ] += n + ( f - n ) * weights[ j ];
+		}
+	}
+}
+
+// layer on grid of samples step voxels apart. sum of gain^o * perlin( p *
+// 2^o ) over octaves o, divided by sum of weights so it stays in range of
+// one octave. every octave is shifted so their lattices do not line up at
+// origin, octaves wider than step are sampled on their own coarser grid
+static void
+sample_layer( Layer             layer,
+              const glm::ivec2& origin,
+              int32_t           step,
+              float*            grid )
+{
+	const NoiseLayer& params = LAYERS[ layer ];
+	const glm::vec2&  offset = terrain.offsets[ layer ];
+
+	float total  = 0.0f;
+	float weight = 1.0f;
+
+	for ( int32_t o = 0; o < params.octaves; o++ )
+	{
+		total += weight;
+		weight *= params.gain;
+	}
+
+	int32_t grid_size = CHUNK_SIZE / step + 1;
+	float   x[ GRID_SAMPLES ];
+	float   z[ GRID_SAMPLES ];
+	float   octave[ GRID_SAMPLES ];
+
+	weight = 1.0f / total;
+	std::fill( grid, grid + grid_size * grid_size, 0.0f );
+
+	for ( int32_t o = 0; o < params.octaves; o++ )
+	{
+		float   frequency = float( 1 << o );
+		float   shift     = float( o ) * 19.19f;
+		int32_t octave_step =
+		    std::max( sample_step( params.scale / frequency ), step );
+		int32_t size  = CHUNK_SIZE / octave_step + 1;
+		int32_t count = size * size;
+
+		for ( int32_t j = 0; j < size; j++ )
+		{
+			for ( int32_t i = 0; i < size; i++ )
+			{
+				float px = float( origin.x + i * octave_step ) / params.scale;
+				float pz = float( origin.y + j * octave_step ) / params.scale;
+
+				x[ i + size * j ] = ( px + offset.x ) * frequency + shift;
+				z[ i + size * j ] = ( pz + offset.y ) * frequency + shift;
+			}
+		}
+
+		noise_batch( x, z, octave, size_t( count ) );
+
+		for ( int32_t i = 0; i < count; i++ )
+		{
+			octave[ i ] *= weight;
+		}
+
+		if ( octave_step == step )
+		{
+			for ( int32_t i = 0; i < count; i++ )
+			{
+				grid[ i ] += octave[ i ];
+			}
+		}
+		else
+		{
+			add_resampled( octave, octave_step, grid, step );
+		}
+
+		weight *= params.gain;
+	}
+}
+
+// grid of samples step voxels apart interpolated along z, row holds one
+// value every step voxels of row z
+static inline void
+grid_row( const float* grid, int32_t step, int32_t z, float* row )
+{
+	int32_t      size = CHUNK_SIZE / step + 1;
+	const float* near = grid + size * ( z / step );
+	const float* far  = near + size;
+	float        f    = float( z % step ) / float( step );
+
+	for ( int32_t i = 0; i < size; i++ )
+	{
+		row[ i ] = near[ i ] + ( far[ i ] - near[ i ] ) * f;
+	}
+}
+
+// value at voxel x of row of samples step voxels apart
+static inline float
+row_value( const float* row, int32_t step, int32_t x )
+{
+	const float* c = row + x / step;
+	float        f = float( x % step ) / float( step );
+
+	return c[ 0 ] + ( c[ 1 ] - c[ 0 ] ) * f;
+}
+
+// biome of largest blend weight, closest in climate
+static Biome::Type
+nearest_biome( float temperature, float humidity )
+{
+	float       nearest = INFINITY;
+	Biome::Type biome   = Biome::PLAINS;
+
+	for ( int32_t b = 0; b < CLIMATE_BIOME_COUNT; b++ )
+	{
+		float dt = temperature - BIOMES[ b ].temperature;
+		float dh = humidity - BIOMES[ b ].humidity;
+		float d  = dt * dt + dh * dh;
+
+		if ( d < nearest )
+		{
+			nearest = d;
+			biome   = Biome::Type( b );
+		}
+	}
+
+	return biome;
+}
+
+void
+generate_heightmap( Heightmap& heightmap, const glm::ivec2 column_position )
+{
+	glm::ivec2 origin = column_position * CHUNK_SIZE;
+
+	float temperature[ GRID_SAMPLES ];
+	float humidity[ GRID_SAMPLES ];
+	float relief[ GRID_SAMPLES ];
+	float detail[ GRID_SAMPLES ];
+
+	sample_layer( TEMPERATURE, origin, BLEND_STEP, temperature );
+	sample_layer( HUMIDITY, origin, BLEND_STEP, humidity );
+	sample_layer( RELIEF, origin, BLEND_STEP, relief );
+	sample_layer( DETAIL, origin, DETAIL_STEP, detail );
+
+	// height is level + detail_scale * detail, both follow from blended
+	// biome parameters and relief
+	float levels[ BLEND_SIZE * BLEND_SIZE ];
+	float detail_scales[ BLEND_SIZE * BLEND_SIZE ];
+
+	for ( int32_t i = 0; i < BLEND_SIZE * BLEND_SIZE; i++ )
+	{
+		// parameters, not heights, are blended, so borders stay as
+		// continuous as the noise
+		float total     = 0.0f;
+		float base      = 0.0f;
+		float amplitude = 0.0f;
+		float roughness = 0.0f;
+
+		for ( int32_t b = 0; b < CLIMATE_BIOME_COUNT; b++ )
+		{
+			const BiomeParameters& params = BIOMES[ b ];
+
+			float dt     = temperature[ i ] - params.temperature;
+			float dh     = humidity[ i ] - params.humidity;
+			float d      = dt * dt + dh * dh + BIOME_BLEND;
+			float weight = 1.0f / ( d * d );
+
+			total += weight;
+			base += weight * params.base;
+			amplitude += weight * params.amplitude;
+			roughness += weight * params.roughness;
+		}
+
+		base /= total;
+		amplitude /= total;
+		roughness /= total;
+
+		float shape        = amplitude / ( 1.0f + roughness );
+		levels[ i ]        = base + shape * relief[ i ];
+		detail_scales[ i ] = shape * roughness;
+	}
+
+	for ( int32_t z = 0; z < CHUNK_SIZE; z++ )
+	{
+		float temperature_row[ BLEND_SIZE ];
+		float humidity_row[ BLEND_SIZE ];
+		float level_row[ BLEND_SIZE ];
+		float detail_scale_row[ BLEND_SIZE ];
+		float detail_row[ DETAIL_SIZE ];
+
+		grid_row( temperature, BLEND_STEP, z, temperature_row );
+		grid_row( humidity, BLEND_STEP, z, humidity_row );
+		grid_row( levels, BLEND_STEP, z, level_row );
+		grid_row( detail_scales, BLEND_STEP, z, detail_scale_row );
+		grid_row( detail, DETAIL_STEP, z, detail_row );
+
+		// differences of climate distances are linear along a cell of row,
+		// biome nearest at both ends of it is nearest at all of its voxels
+		Biome::Type row_biomes[ BLEND_SIZE ];
+
+		for ( int32_t i = 0; i < BLEND_SIZE; i++ )
+		{
+			row_biomes[ i ] =
+			    nearest_biome( temperature_row[ i ], humidity_row[ i ] );
+		}
+
+		for ( int32_t x = 0; x < CHUNK_SIZE; x++ )
+		{
+			int32_t     cell  = x / BLEND_STEP;
+			Biome::Type biome = row_biomes[ cell ];
+
+			if ( row_biomes[ cell + 1 ] != biome )
+			{
+				biome = nearest_biome(
+				    row_value( temperature_row, BLEND_STEP, x ),
+				    row_value( humidity_row, BLEND_STEP, x ) );
+			}
+
+			float level = row_value( level_row, BLEND_STEP, x ) +
+			              row_value( detail_scale_row, BLEND_STEP, x ) *
+			                  row_value( detail_row, DETAIL_STEP, x );
+			int32_t height = std::clamp( int32_t( std::floor( level ) ),
+			                             TERRAIN_BASE_HEIGHT + 2,
+			                             MAX_TERRAIN_HEIGHT );
+
+			int32_t i              = x + CHUNK_SIZE * z;
+			heightmap.heights[ i ] = height;
+			heightmap.biomes[ i ] =
+			    height < BEACH_HEIGHT ? Biome::BEACH : biome;
+		}
+	}
+}
+
+static inline float
+cave_threshold( int32_t y )
+{
+	float depth = std::clamp( float( y ) / TERRAIN_BASE_HEIGHT, 0.0f, 1.0f );
+	return CAVE_THRESHOLD_DEEP +
+	       ( CAVE_THRESHOLD_SURFACE - CAVE_THRESHOLD_DEEP ) * depth;
+}
+
+// every field at lattice points, corners of one cell and ends of one row
+// of voxels in it
+using CaveFields  = float[ CAVE_FIELDS ][ CAVE_SAMPLES ];
+using CaveCorners = float[ CAVE_FIELDS ][ 8 ];
+using CaveRow     = float[ CAVE_FIELDS ][ 2 ];
+
+// cave fields at count lattice points given in world voxels
+static void
+sample_fields( const glm::ivec3* points, size_t count, CaveFields& fields )
+{
+	float x[ CAVE_SAMPLES ];
+	float y[ CAVE_SAMPLES ];
+	float z[ CAVE_SAMPLES ];
+
+	for ( int32_t f = 0; f < CAVE_FIELDS; f++ )
+	{
+		const glm::vec3& offset = terrain.cave_offsets[ f ];
+
+		for ( size_t i = 0; i < count; i++ )
+		{
+			x[ i ] = float( points[ i ].x ) / CAVE_SCALE + offset.x;
+			y[ i ] = float( points[ i ].y ) / CAVE_VERTICAL_SCALE + offset.y;
+			z[ i ] = float( points[ i ].z ) / CAVE_SCALE + offset.z;
+		}
+
+		noise_batch( x, y, z, fields[ f ], count );
+	}
+}
+
+// corners in order ( 0, 0, 0 ), ( 1, 0, 0 ), ( 0, 1, 0 ), ( 1, 1, 0 ), then
+// same with z = 1. fields at both ends of row of voxels at dy and dz in
+// cell, voxels along row are one interpolation away
+static inline void
+interpolate_row( const CaveCorners& corners,
+                 int32_t            dy,
+                 int32_t            dz,
+                 CaveRow&           row )
+{
+	float fy = CAVE_WEIGHTS[ dy ];
+	float fz = CAVE_WEIGHTS[ dz ];
+
+	for ( int32_t f = 0; f < CAVE_FIELDS; f++ )
+	{
+		const float* c = corners[ f ];
+
+		for ( int32_t x = 0; x < 2; x++ )
+		{
+			float near = c[ x ] + ( c[ x + 4 ] - c[ x ] ) * fz;
+			float far  = c[ x + 2 ] + ( c[ x + 6 ] - c[ x + 2 ] ) * fz;
+
+			row[ f ][ x ] = near + ( far - near ) * fy;
+		}
+	}
+}
+
+// fields are interpolated before squaring, squares of them would not be
+// linear enough to interpolate. used for sections and single voxels alike
+// so both round same
+static inline float
+row_density( const CaveRow& row, int32_t dx, float threshold )
+{
+	float fx      = CAVE_WEIGHTS[ dx ];
+	float density = -threshold;
+
+	for ( int32_t f = 0; f < CAVE_FIELDS; f++ )
+	{
+		float field = row[ f ][ 0 ] + ( row[ f ][ 1 ] - row[ f ][ 0 ] ) * fx;
+		density += field * field;
+	}
+
+	return density;
+}
+
+// no voxel of cell is carved when even lowest possible density is not
+// negative. interpolated field keeps sign of corners and stays at least
+// as far from zero as closest of them when none crosses zero
+static bool
+is_solid_cell( const CaveCorners& corners, int32_t bottom )
+{
+	float lowest = -cave_threshold( bottom );
+
+	for ( int32_t f = 0; f < CAVE_FIELDS; f++ )
+	{
+		float low  = corners[ f ][ 0 ];
+		float high = corners[ f ][ 0 ];
+
+		for ( int32_t i = 1; i < 8; i++ )
+		{
+			low  = std::min( low, corners[ f ][ i ] );
+			high = std::max( high, corners[ f ][ i ] );
+		}
+
+		float nearest = low > 0.0f ? low : high < 0.0f ? -high : 0.0f;
+		lowest += nearest * nearest;
+	}
+
+	return lowest >= 0.0f;
+}
+
+bool
+sample_caves( CaveMask& caves, const glm::ivec3 chunk_position )
+{
+	glm::ivec3 origin = chunk_position * CHUNK_SIZE;
+
+	caves.columns.fill( 0 );
+
+	if ( origin.y + CHUNK_SIZE <= CAVE_FLOOR + 1 )
+	{
+		return false;
+	}
+
+	glm::ivec3 points[ CAVE_SAMPLES ];
+	CaveFields fields;
+
+	for ( int32_t z = 0; z < CAVE_SIZE; z++ )
+	{
+		for ( int32_t y = 0; y < CAVE_SIZE; y++ )
+		{
+			for ( int32_t x = 0; x < CAVE_SIZE; x++ )
+			{
+				points[ x + CAVE_SIZE * ( y + CAVE_SIZE * z ) ] =
+				    origin + glm::ivec3( x, y, z ) * CAVE_STEP;
+			}
+		}
+	}
+
+	sample_fields( points, CAVE_SAMPLES, fields );
+
+	bool carved = false;
+
+	for ( int32_t z = 0; z < CAVE_CELLS; z++ )
+	{
+		for ( int32_t y = 0; y < CAVE_CELLS; y++ )
+		{
+			for ( int32_t x = 0; x < CAVE_CELLS; x++ )
+			{
+				int32_t     first = x + CAVE_SIZE * ( y + CAVE_SIZE * z );
+				CaveCorners corners;
+
+				for ( int32_t f = 0; f < CAVE_FIELDS; f++ )
+				{
+					const float* c = fields[ f ] + first;
+
+					corners[ f ][ 0 ] = c[ 0 ];
+					corners[ f ][ 1 ] = c[ 1 ];
+					corners[ f ][ 2 ] = c[ CAVE_SIZE ];
+					corners[ f ][ 3 ] = c[ CAVE_SIZE + 1 ];
+					corners[ f ][ 4 ] = c[ CAVE_SIZE * CAVE_SIZE ];
+					corners[ f ][ 5 ] = c[ CAVE_SIZE * CAVE_SIZE + 1 ];
+					corners[ f ][ 6 ] = c[ CAVE_SIZE * CAVE_SIZE + CAVE_SIZE ];
+					corners[ f ][ 7 ] =
+					    c[ CAVE_SIZE * CAVE_SIZE + CAVE_SIZE + 1 ];
+				}
+
+				glm::ivec3 cell = glm::ivec3( x, y, z ) * CAVE_STEP;
+
+				// most cells are skipped here
+				if ( is_solid_cell( corners, origin.y + cell.y ) )
+				{
+					continue;
+				}
+
+				for ( int32_t dz = 0; dz < CAVE_STEP; dz++ )
+				{
+					for ( int32_t dy = 0; dy < CAVE_STEP; dy++ )
+					{
+						int32_t world_y = origin.y + cell.y + dy;
+
+						if ( world_y <= CAVE_FLOOR )
+						{
+							continue;
+						}
+
+						float   threshold = cave_threshold( world_y );
+						CaveRow row;
+						interpolate_row( corners, dy, dz, row );
+
+						for ( int32_t dx = 0; dx < CAVE_STEP; dx++ )
+						{
+							if ( row_density( row, dx, threshold ) >= 0.0f )
+							{
+								continue;
+							}
+
+							glm::ivec3 v = cell + glm::ivec3( dx, dy, dz );
+							caves.columns[ v.x + CHUNK_SIZE * v.z ] |=
+							    1u << v.y;
+							carved = true;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return carved;
+}
+
+bool
+sample_caves_exact( CaveMask& caves, const glm::ivec3 chunk_position )
+{
+	glm::ivec3 origin = chunk_position * CHUNK_SIZE;
+	bool       carved = false;
+
+	caves.columns.fill( 0 );
+
+	// one xy slice of section at a time, index x + CHUNK_SIZE * y
+	float x[ CHUNK_SIZE_SQUARED ];
+	float y[ CHUNK_SIZE_SQUARED ];
+	float z[ CHUNK_SIZE_SQUARED ];
+	float fields[ CAVE_FIELDS ][ CHUNK_SIZE_SQUARED ];
+
+	for ( int32_t dz = 0; dz < CHUNK_SIZE; dz++ )
+	{
+		for ( int32_t f = 0; f < CAVE_FIELDS; f++ )
+		{
+			const glm::vec3& offset = terrain.cave_offsets[ f ];
+
+			for ( int32_t i = 0; i < CHUNK_SIZE_SQUARED; i++ )
+			{
+				glm::ivec3 v = origin + glm::ivec3( i % CHUNK_SIZE,
+				                                    i / CHUNK_SIZE,
+				                                    dz );
+
+				x[ i ] = float( v.x ) / CAVE_SCALE + offset.x;
+				y[ i ] = float( v.y ) / CAVE_VERTICAL_SCALE + offset.y;
+				z[ i ] = float( v.z ) / CAVE_SCALE + offset.z;
+			}
+
+			noise_batch( x, y, z, fields[ f ], CHUNK_SIZE_SQUARED );
+		}
+
+		for ( int32_t i = 0; i < CHUNK_SIZE_SQUARED; i++ )
+		{
+			int32_t world_y = origin.y + i / CHUNK_SIZE;
+
+			if ( world_y <= CAVE_FLOOR )
+			{
+				continue;
+			}
+
+			float density = -cave_threshold( world_y );
+
+			for ( int32_t f = 0; f < CAVE_FIELDS; f++ )
+			{
+				density += fields[ f ][ i ] * fields[ f ][ i ];
+			}
+
+			if ( density < 0.0f )
+			{
+				caves.columns[ i % CHUNK_SIZE + CHUNK_SIZE * dz ] |=
+				    1u << ( i / CHUNK_SIZE );
+				carved = true;
+			}
+		}
+	}
+
+	return carved;
+}
+
+bool
+is_cave_voxel( const glm::ivec3 world_position )
+{
+	if ( world_position.y <= CAVE_FLOOR )
+	{
+		return false;
+	}
+
+	glm::ivec3 offset =
+	    ( world_position % CAVE_STEP + CAVE_STEP ) % CAVE_STEP;
+	glm::ivec3 corner = world_position - offset;
+	glm::ivec3 points[ 8 ];
+
+	for ( int32_t i = 0; i < 8; i++ )
+	{
+		points[ i ] = corner + glm::ivec3( i & 1, ( i >> 1 ) & 1, i >> 2 ) *
+		                           CAVE_STEP;
+	}
+
+	CaveFields  fields;
+	CaveCorners corners;
+	sample_fields( points, 8, fields );
+
+	for ( int32_t f = 0; f < CAVE_FIELDS; f++ )
+	{
+		std::copy( fields[ f ], fields[ f ] + 8, corners[ f ] );
+	}
+
+	CaveRow row;
+	interpolate_row( corners, offset.y, offset.z, row );
+
+	return row_density( row, offset.x, cave_threshold( world_position.y ) ) <
+	       0.0f;
+}
+
+Voxel::Type
+column_voxel( int32_t y, int32_t top, Biome::Type biome )
+{
+	// 0 for surface voxel
+	int32_t depth = top - 1 - y;
+	// counts class boundaries depth is past instead of branching
+	int32_t depth_class = ( depth > 0 ) + ( depth >= FILLER_DEPTH );
+
+	return DEPTH_VOXELS[ biome ][ depth_class ];
+}
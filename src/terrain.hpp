@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <glm/glm.hpp>
+#include "constants.hpp"
+#include "voxel.hpp"
+
+struct Biome
+{
+	enum Type : uint8_t
+	{
+		PLAINS,
+		FOREST,
+		DESERT,
+		MOUNTAINS,
+		// shores below other biomes, picked by height instead of climate
+		BEACH,
+		COUNT
+	};
+};
+
+// surface of a column for every ( x, z ), index is x + CHUNK_SIZE * z
+struct Heightmap
+{
+	// world height of first AIR voxel above terrain
+	std::array<int32_t, CHUNK_SIZE_SQUARED> heights;
+	// strongest biome, heights blend all of them near borders
+	std::array<Biome::Type, CHUNK_SIZE_SQUARED> biomes;
+};
+
+static_assert( CHUNK_SIZE < 32, "cave column must fit in a uint32_t" );
+
+// voxels of a section carved out by caves
+struct CaveMask
+{
+	// bit y of column x + CHUNK_SIZE * z is set when ( x, y, z ) is carved,
+	// whole runs of a column are filled or skipped at once
+	std::array<uint32_t, CHUNK_SIZE_SQUARED> columns;
+};
+
+// neighboring inputs give unrelated outputs, randomness of generation is
+// drawn from it so same seed always places same things
+static inline uint32_t
+hash_bits( uint32_t x )
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// noise layers are shifted by seed, same seed generates same terrain.
+// call before any generation starts
+void
+init_terrain( uint32_t seed );
+
+uint32_t
+get_world_seed();
+
+void
+generate_heightmap( Heightmap& heightmap, const glm::ivec2 column_position );
+
+// cave noise is sampled at corners of 4x4x4 voxel cells and interpolated
+// in between, 125 noise evaluations per field instead of 4096. corners
+// lie on a world aligned lattice, so caves continue across section
+// borders. false when nothing in section is carved
+bool
+sample_caves( CaveMask& caves, const glm::ivec3 chunk_position );
+
+// noise evaluated at every voxel instead of interpolated, reference
+// sample_caves is measured against
+bool
+sample_caves_exact( CaveMask& caves, const glm::ivec3 chunk_position );
+
+static inline bool
+is_cave( const CaveMask& caves, const glm::ivec3 local_position )
+{
+	uint32_t column =
+	    caves.columns[ local_position.x + CHUNK_SIZE * local_position.z ];
+	return ( column >> local_position.y & 1u ) != 0;
+}
+
+// same as sampling section of world_position and reading it with is_cave,
+// for single voxels of sections not generated here
+bool
+is_cave_voxel( const glm::ivec3 world_position );
+
+// generated voxel at world height y of a column whose surface is at top
+Voxel::Type
+column_voxel( int32_t y, int32_t top, Biome::Type biome );
@@ -8,12 +8,22 @@ struct Vertex
 	glm::vec3 pos;
 	glm::vec2 tex;
 	float     face;
+	// packed Light of voxel in front of face, unpacked by shader
+	float light;
+	// ambient occlusion of this corner, 0 is darkest and 3 unoccluded
+	float ao;
 
 	Vertex() = default;
-	Vertex( const glm::vec3 position, const glm::vec2 texture, float face )
+	Vertex( const glm::vec3 position,
+	        const glm::vec2 texture,
+	        float           face,
+	        float           light,
+	        float           ao )
 	    : face( face )
 	    , pos( position )
 	    , tex( texture )
+	    , light( light )
+	    , ao( ao )
 	{
 	}
 
@@ -25,7 +35,7 @@ struct Vertex
 		layout.binding_infos[ 0 ].binding    = 0;
 		layout.binding_infos[ 0 ].input_rate = FT_VERTEX_INPUT_RATE_VERTEX;
 		layout.binding_infos[ 0 ].stride     = sizeof( Vertex );
-		layout.attribute_info_count          = 3;
+		layout.attribute_info_count          = 5;
 		layout.attribute_infos[ 0 ].binding  = 0;
 		layout.attribute_infos[ 0 ].format   = FT_FORMAT_R32G32B32_SFLOAT;
 		layout.attribute_infos[ 0 ].location = 0;
@@ -38,6 +48,14 @@ struct Vertex
 		layout.attribute_infos[ 2 ].format   = FT_FORMAT_R32_SFLOAT;
 		layout.attribute_infos[ 2 ].location = 2;
 		layout.attribute_infos[ 2 ].offset   = 5 * sizeof( float );
+		layout.attribute_infos[ 3 ].binding  = 0;
+		layout.attribute_infos[ 3 ].format   = FT_FORMAT_R32_SFLOAT;
+		layout.attribute_infos[ 3 ].location = 3;
+		layout.attribute_infos[ 3 ].offset   = 6 * sizeof( float );
+		layout.attribute_infos[ 4 ].binding  = 0;
+		layout.attribute_infos[ 4 ].format   = FT_FORMAT_R32_SFLOAT;
+		layout.attribute_infos[ 4 ].location = 4;
+		layout.attribute_infos[ 4 ].offset   = 7 * sizeof( float );
 
 		return layout;
 	}
@@ -25,6 +25,7 @@ struct VoxelDataStorage
 {
 	std::array<VoxelData, Voxel::COUNT> sprite_data;
 	std::array<bool, Voxel::COUNT>      transparent;
+	std::array<uint8_t, Voxel::COUNT>   emission;
 } voxel_data_storage;
 
 void
@@ -42,11 +43,18 @@ init_voxel_data_storage()
 	s[ Voxel::GRASS ].set_all( 2 ).set( Face::BOTTOM, 3 ).set( Face::TOP, 1 );
 	s[ Voxel::WOOD ].set_all( 6 ).set( Face::BOTTOM, 7 ).set( Face::TOP, 7 );
 	s[ Voxel::LEAVES ].set_all( 10 );
+	// no sprite of its own yet
+	s[ Voxel::LAMP ].set_all( 4 );
 
 	t.fill( false );
 	t[ Voxel::LEAVES ] = true;
 	t[ Voxel::GLASS ]  = true;
 	t[ Voxel::AIR ]    = true;
+
+	auto& e = voxel_data_storage.emission;
+
+	e.fill( 0 );
+	e[ Voxel::LAMP ] = MAX_LIGHT - 1;
 }
 
 void
@@ -65,3 +73,9 @@ is_transparent( Voxel::Type voxel )
 {
 	return voxel_data_storage.transparent[ voxel ];
 }
+
+uint8_t
+get_light_emission( Voxel::Type voxel )
+{
+	return voxel_data_storage.emission[ voxel ];
+}
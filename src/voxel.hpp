@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <fluent/renderer.h>
 #include <glm/glm.hpp>
+#include "constants.hpp"
 #include "quad.hpp"
 
 struct Voxel
@@ -18,6 +19,7 @@ struct Voxel
 		STONE  = 6,
 		WATER  = 7,
 		LEAVES = 8,
+		LAMP   = 9,
 		COUNT
 	};
 };
@@ -30,3 +32,32 @@ get_uv( glm::vec2& r, Voxel::Type voxel, Face::Type face );
 
 bool
 is_transparent( Voxel::Type voxel );
+
+// opaque voxels neither hold nor pass light
+static inline bool
+is_opaque( Voxel::Type voxel )
+{
+	return !is_transparent( voxel );
+}
+
+// block light level voxel gives off, only opaque voxels emit
+uint8_t
+get_light_emission( Voxel::Type voxel );
+
+// light of a voxel, sky light in high nibble and block light in low one
+using Light = uint8_t;
+
+// what AIR under open sky holds, also implied for unallocated sections
+static constexpr Light OPEN_SKY_LIGHT = MAX_LIGHT << 4;
+
+static inline uint8_t
+get_sky_light( Light light )
+{
+	return light >> 4;
+}
+
+static inline uint8_t
+get_block_light( Light light )
+{
+	return light & 0xF;
+}
@@ -0,0 +1,92 @@
+#include "voxel_storage.hpp"
+
+FlatVoxelStorage::FlatVoxelStorage()
+{
+	fill( Voxel::AIR );
+}
+
+void
+FlatVoxelStorage::fill( Voxel::Type voxel )
+{
+	voxels.fill( voxel );
+}
+
+PaletteVoxelStorage::PaletteVoxelStorage()
+{
+	fill( Voxel::AIR );
+}
+
+void
+PaletteVoxelStorage::fill( Voxel::Type voxel )
+{
+	lookup.fill( INVALID_INDEX );
+	palette[ 0 ]    = voxel;
+	lookup[ voxel ] = 0;
+	palette_count   = 1;
+	bits            = 0;
+	mask            = 0;
+	// assign keeps capacity so recycled chunks do not hit the allocator
+	words.assign( 1, 0 );
+}
+
+void
+PaletteVoxelStorage::set( uint32_t idx, Voxel::Type voxel )
+{
+	uint8_t index = lookup[ voxel ];
+
+	if ( index == INVALID_INDEX )
+	{
+		if ( palette_count == ( 1u << bits ) )
+		{
+			grow();
+		}
+
+		index                    = palette_count;
+		palette[ palette_count ] = voxel;
+		lookup[ voxel ]          = index;
+		palette_count++;
+	}
+
+	uint32_t bit   = idx * bits;
+	uint64_t shift = bit % WORD_BITS;
+	uint64_t& word = words[ bit / WORD_BITS ];
+
+	word = ( word & ~( mask << shift ) ) | ( uint64_t( index ) << shift );
+}
+
+void
+PaletteVoxelStorage::grow()
+{
+	uint32_t new_bits = bits == 0 ? 1 : bits * 2;
+	uint64_t new_mask = ( uint64_t( 1 ) << new_bits ) - 1;
+
+	if ( bits == 0 )
+	{
+		// every index is 0
+		words.assign( CHUNK_SIZE_CUBED * new_bits / WORD_BITS, 0 );
+	}
+	else
+	{
+		// widened in place, buffer of recycled chunk is already big enough.
+		// new word w holds voxels of half w % 2 of old word w / 2, going
+		// backwards every old word is read before it is overwritten
+		words.resize( words.size() * 2 );
+		uint32_t fields = WORD_BITS / new_bits;
+
+		for ( size_t w = words.size(); w-- > 0; )
+		{
+			uint64_t half = words[ w / 2 ] >> ( w % 2 * ( WORD_BITS / 2 ) );
+			uint64_t word = 0;
+
+			for ( uint32_t f = 0; f < fields; f++ )
+			{
+				word |= ( ( half >> ( f * bits ) ) & mask ) << ( f * new_bits );
+			}
+
+			words[ w ] = word;
+		}
+	}
+
+	bits = new_bits;
+	mask = new_mask;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include "constants.hpp"
+#include "voxel.hpp"
+
+// plain array, two bytes per voxel
+struct FlatVoxelStorage
+{
+	std::array<Voxel::Type, CHUNK_SIZE_CUBED> voxels;
+
+	FlatVoxelStorage();
+
+	void
+	fill( Voxel::Type voxel );
+
+	Voxel::Type
+	get( uint32_t idx ) const
+	{
+		return voxels[ idx ];
+	}
+
+	void
+	set( uint32_t idx, Voxel::Type voxel )
+	{
+		voxels[ idx ] = voxel;
+	}
+
+	// heap bytes in use outside of the struct itself
+	size_t
+	heap_usage() const
+	{
+		return 0;
+	}
+
+	uint32_t
+	palette_size() const
+	{
+		return Voxel::COUNT;
+	}
+};
+
+// voxels are stored as 0/1/2/4/8 bit indices into a small per chunk palette,
+// width grows when set() writes a type which is not in palette yet
+struct PaletteVoxelStorage
+{
+	static constexpr uint32_t WORD_BITS     = 64;
+	static constexpr uint8_t  INVALID_INDEX = 0xFF;
+
+	static_assert( Voxel::COUNT <= 256, "palette index must fit 8 bits" );
+
+	std::array<Voxel::Type, Voxel::COUNT> palette;
+	// voxel type -> palette index
+	std::array<uint8_t, Voxel::COUNT> lookup;
+	uint32_t                          palette_count;
+	uint32_t                          bits;
+	uint64_t                          mask;
+	// uniform chunk keeps one zero word so get() need no branch on bits == 0
+	std::vector<uint64_t> words;
+
+	PaletteVoxelStorage();
+
+	void
+	fill( Voxel::Type voxel );
+
+	Voxel::Type
+	get( uint32_t idx ) const
+	{
+		uint32_t bit  = idx * bits;
+		uint64_t word = words[ bit / WORD_BITS ];
+		return palette[ ( word >> ( bit % WORD_BITS ) ) & mask ];
+	}
+
+	void
+	set( uint32_t idx, Voxel::Type voxel );
+
+	// bytes current indices take, buffer of a recycled chunk may be larger
+	size_t
+	heap_usage() const
+	{
+		return words.size() * sizeof( uint64_t );
+	}
+
+	uint32_t
+	palette_size() const
+	{
+		return palette_count;
+	}
+
+private:
+	void
+	grow();
+};
+
+#if defined( VK_CRAFT_PALETTE_STORAGE )
+using VoxelStorage = PaletteVoxelStorage;
+#else
+using VoxelStorage = FlatVoxelStorage;
+#endif
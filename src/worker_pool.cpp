@@ -0,0 +1,107 @@
+#include <algorithm>
+#include "worker_pool.hpp"
+
+void
+WorkerPool::init( uint32_t worker_count )
+{
+	running        = true;
+	task           = nullptr;
+	task_count     = 0;
+	range_size     = 0;
+	next_begin     = 0;
+	pending_ranges = 0;
+
+	for ( uint32_t i = 0; i < worker_count; i++ )
+	{
+		workers.emplace_back( &WorkerPool::worker_loop, this );
+	}
+}
+
+void
+WorkerPool::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		running = false;
+	}
+
+	condition.notify_all();
+
+	for ( std::thread& worker : workers )
+	{
+		worker.join();
+	}
+
+	workers.clear();
+}
+
+void
+WorkerPool::worker_loop()
+{
+	std::unique_lock<std::mutex> lock( mutex );
+
+	for ( ;; )
+	{
+		// task_count is 0 between batches
+		condition.wait( lock,
+		                [ & ] { return !running || next_begin < task_count; } );
+
+		if ( !running )
+		{
+			return;
+		}
+
+		run_ranges( lock );
+	}
+}
+
+void
+WorkerPool::run_ranges( std::unique_lock<std::mutex>& lock )
+{
+	while ( next_begin < task_count )
+	{
+		size_t begin = next_begin;
+		size_t end   = std::min( begin + range_size, task_count );
+		next_begin   = end;
+
+		// task outlives every range, run() waits for all of them
+		lock.unlock();
+		( *task )( begin, end );
+		lock.lock();
+
+		if ( --pending_ranges == 0 )
+		{
+			done_condition.notify_all();
+		}
+	}
+}
+
+void
+WorkerPool::run( size_t count, size_t range_size, const Task& task )
+{
+	if ( count == 0 )
+	{
+		return;
+	}
+
+	if ( workers.empty() || count <= range_size )
+	{
+		task( 0, count );
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock( mutex );
+	this->task       = &task;
+	this->range_size = range_size;
+	task_count       = count;
+	next_begin       = 0;
+	pending_ranges   = ( count + range_size - 1 ) / range_size;
+
+	condition.notify_all();
+
+	run_ranges( lock );
+	done_condition.wait( lock, [ & ] { return pending_ranges == 0; } );
+
+	this->task = nullptr;
+	task_count = 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// threads kept alive between batches. run() splits a batch of independent
+// tasks into ranges which workers and calling thread take in turn, so
+// nothing is created or joined per batch. one batch at a time
+class WorkerPool
+{
+public:
+	using Task = std::function<void( size_t begin, size_t end )>;
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex               mutex;
+	// wakes workers when batch starts or pool shuts down
+	std::condition_variable condition;
+	std::condition_variable done_condition;
+	bool                    running;
+
+	// batch in progress, task is nullptr between batches
+	const Task* task;
+	size_t      task_count;
+	size_t      range_size;
+	size_t      next_begin;
+	size_t      pending_ranges;
+
+	void
+	worker_loop();
+
+	// runs ranges of current batch until none are left
+	void
+	run_ranges( std::unique_lock<std::mutex>& lock );
+
+public:
+	void
+	init( uint32_t worker_count );
+
+	void
+	shutdown();
+
+	// calls task( begin, end ) for ranges of at most range_size covering
+	// 0 to count and returns once all of them are done. batches of one
+	// range run on calling thread only
+	void
+	run( size_t count, size_t range_size, const Task& task );
+
+	uint32_t
+	get_worker_count() const
+	{
+		return uint32_t( workers.size() );
+	}
+};
@@ -0,0 +1,407 @@
+#include <cstring>
+#include <filesystem>
+#include "chunk_pool.hpp"
+#include "chunk_column.hpp"
+#include "world_storage.hpp"
+
+// voxels are stored in this order regardless of storage layout, y last so
+// horizontal terrain layers become long runs
+static inline glm::ivec3
+payload_position( int32_t i )
+{
+	return { i % CHUNK_SIZE,
+	         i / CHUNK_SIZE_SQUARED,
+	         ( i / CHUNK_SIZE ) % CHUNK_SIZE };
+}
+
+static inline int32_t
+floor_div( int32_t a, int32_t b )
+{
+	return a / b - ( a % b < 0 );
+}
+
+static inline glm::ivec2
+region_of( const glm::ivec2 column_position )
+{
+	return { floor_div( column_position.x, RegionFile::REGION_SIZE ),
+	         floor_div( column_position.y, RegionFile::REGION_SIZE ) };
+}
+
+template <typename T>
+static inline void
+put( std::vector<uint8_t>& payload, T value )
+{
+	size_t offset = payload.size();
+	payload.resize( offset + sizeof( T ) );
+	memcpy( payload.data() + offset, &value, sizeof( T ) );
+}
+
+template <typename T>
+static inline bool
+take( const std::vector<uint8_t>& payload, size_t& offset, T& value )
+{
+	if ( offset + sizeof( T ) > payload.size() )
+	{
+		return false;
+	}
+
+	memcpy( &value, payload.data() + offset, sizeof( T ) );
+	offset += sizeof( T );
+
+	return true;
+}
+
+void
+WorldStorage::init( const std::string& directory,
+                    Mode               mode,
+                    ChunkManager*      chunk_manager,
+                    ChunkPool*         chunk_pool )
+{
+	this->directory     = directory;
+	this->mode          = mode;
+	this->chunk_manager = chunk_manager;
+	this->chunk_pool    = chunk_pool;
+	stats               = {};
+
+	std::error_code error;
+	std::filesystem::create_directories( directory, error );
+}
+
+void
+WorldStorage::shutdown()
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	regions.clear();
+}
+
+RegionFile*
+WorldStorage::find_region( const glm::ivec2 region, bool create )
+{
+	auto it = regions.find( region );
+
+	if ( it != regions.end() && ( it->second != nullptr || !create ) )
+	{
+		return it->second.get();
+	}
+
+	std::string path = directory + "/r." + std::to_string( region.x ) + "." +
+	                   std::to_string( region.y ) + ".region";
+
+	std::unique_ptr<RegionFile> file;
+
+	// open would create empty file for every region player walks through
+	if ( create || std::filesystem::exists( path ) )
+	{
+		file = std::make_unique<RegionFile>();
+		if ( !file->open( path ) )
+		{
+			file = nullptr;
+		}
+	}
+
+	RegionFile* result = file.get();
+	regions[ region ]  = std::move( file );
+
+	if ( result != nullptr )
+	{
+		stats.open_regions++;
+	}
+
+	return result;
+}
+
+void
+WorldStorage::encode_column( const ChunkColumn&    column,
+                             std::vector<uint8_t>& payload )
+{
+	uint16_t section_mask = 0;
+
+	for ( int32_t y = 0; y < WORLD_HEIGHT_IN_CHUNKS; y++ )
+	{
+		if ( column.sections[ y ] != nullptr )
+		{
+			section_mask |= 1u << y;
+		}
+	}
+
+	put( payload, uint8_t( SECTIONS ) );
+	put( payload, section_mask );
+
+	std::vector<uint16_t> runs;
+
+	for ( const Chunk* chunk : column.sections )
+	{
+		if ( chunk == nullptr )
+		{
+			continue;
+		}
+
+		runs.clear();
+
+		for ( int32_t i = 0; i < CHUNK_SIZE_CUBED; )
+		{
+			Voxel::Type voxel  = chunk->get_voxel( payload_position( i ) );
+			int32_t     length = 1;
+
+			while ( i + length < CHUNK_SIZE_CUBED &&
+			        chunk->get_voxel( payload_position( i + length ) ) ==
+			            voxel )
+			{
+				length++;
+			}
+
+			runs.push_back( voxel );
+			runs.push_back( uint16_t( length ) );
+			i += length;
+		}
+
+		// noisy sections are smaller without run lengths
+		if ( runs.size() < size_t( CHUNK_SIZE_CUBED ) )
+		{
+			put( payload, uint8_t( RUNS ) );
+			put( payload, uint16_t( runs.size() / 2 ) );
+			for ( uint16_t value : runs )
+			{
+				put( payload, value );
+			}
+		}
+		else
+		{
+			put( payload, uint8_t( RAW ) );
+			for ( int32_t i = 0; i < CHUNK_SIZE_CUBED; i++ )
+			{
+				put( payload,
+				     uint16_t( chunk->get_voxel( payload_position( i ) ) ) );
+			}
+		}
+	}
+}
+
+void
+WorldStorage::encode_edits( const ChunkColumn&    column,
+                            std::vector<uint8_t>& payload )
+{
+	put( payload, uint8_t( EDITS ) );
+	put( payload, TERRAIN_VERSION );
+	put( payload, uint32_t( column.edits.size() ) );
+
+	for ( const ColumnEdits::Edit& edit : column.edits.get() )
+	{
+		put( payload, edit.index );
+		put( payload, uint16_t( edit.voxel ) );
+	}
+}
+
+bool
+WorldStorage::decode_column( ChunkColumn&                column,
+                             const std::vector<uint8_t>& payload )
+{
+	// format byte was checked by caller
+	size_t   offset       = 1;
+	uint16_t section_mask = 0;
+
+	if ( !take( payload, offset, section_mask ) )
+	{
+		return false;
+	}
+
+	for ( int32_t y = 0; y < WORLD_HEIGHT_IN_CHUNKS; y++ )
+	{
+		if ( ( section_mask & ( 1u << y ) ) == 0 )
+		{
+			continue;
+		}
+
+		// pooled chunk is already AIR, only solid runs are written
+		Chunk* chunk = chunk_pool->acquire();
+		chunk->attach( glm::ivec3( column.position.x, y, column.position.y ),
+		               chunk_manager,
+		               &column );
+		column.sections[ y ] = chunk;
+
+		uint8_t encoding = 0;
+		if ( !take( payload, offset, encoding ) )
+		{
+			return false;
+		}
+
+		if ( encoding == RAW )
+		{
+			for ( int32_t i = 0; i < CHUNK_SIZE_CUBED; i++ )
+			{
+				uint16_t voxel = 0;
+				if ( !take( payload, offset, voxel ) || voxel >= Voxel::COUNT )
+				{
+					return false;
+				}
+				if ( voxel != Voxel::AIR )
+				{
+					chunk->set_voxel( payload_position( i ),
+					                  Voxel::Type( voxel ) );
+				}
+			}
+			continue;
+		}
+
+		uint16_t run_count = 0;
+		if ( encoding != RUNS || !take( payload, offset, run_count ) )
+		{
+			return false;
+		}
+
+		int32_t i = 0;
+		for ( uint16_t r = 0; r < run_count; r++ )
+		{
+			uint16_t voxel  = 0;
+			uint16_t length = 0;
+			if ( !take( payload, offset, voxel ) ||
+			     !take( payload, offset, length ) || voxel >= Voxel::COUNT ||
+			     i + length > CHUNK_SIZE_CUBED )
+			{
+				return false;
+			}
+
+			if ( voxel != Voxel::AIR )
+			{
+				for ( int32_t j = i; j < i + length; j++ )
+				{
+					chunk->set_voxel( payload_position( j ),
+					                  Voxel::Type( voxel ) );
+				}
+			}
+
+			i += length;
+		}
+	}
+
+	return offset == payload.size();
+}
+
+bool
+WorldStorage::decode_edits( ChunkColumn&                column,
+                            const std::vector<uint8_t>& payload )
+{
+	size_t   offset  = 1;
+	uint8_t  version = 0;
+	uint32_t count   = 0;
+
+	// edits only make sense on terrain they were made on
+	if ( !take( payload, offset, version ) || version != TERRAIN_VERSION ||
+	     !take( payload, offset, count ) )
+	{
+		return false;
+	}
+
+	for ( uint32_t i = 0; i < count; i++ )
+	{
+		uint16_t index = 0;
+		uint16_t voxel = 0;
+		if ( !take( payload, offset, index ) ||
+		     !take( payload, offset, voxel ) || voxel >= Voxel::COUNT )
+		{
+			column.edits.clear();
+			return false;
+		}
+
+		column.edits.set( ColumnEdits::position( index ),
+		                  Voxel::Type( voxel ) );
+	}
+
+	return offset == payload.size();
+}
+
+void
+WorldStorage::save_column( const ChunkColumn& column )
+{
+	std::vector<uint8_t> payload;
+
+	if ( mode == Mode::OVERLAY && !column.snapshot )
+	{
+		encode_edits( column, payload );
+	}
+	else
+	{
+		encode_column( column, payload );
+	}
+
+	glm::ivec2 region = region_of( column.position );
+
+	std::lock_guard<std::mutex> lock( mutex );
+
+	RegionFile* file = find_region( region, true );
+
+	if ( file != nullptr &&
+	     file->write( column.position - region * RegionFile::REGION_SIZE,
+	                  payload ) )
+	{
+		stats.columns_saved++;
+		stats.bytes_written += payload.size();
+	}
+}
+
+bool
+WorldStorage::load_column( ChunkColumn& column )
+{
+	std::vector<uint8_t> payload;
+
+	glm::ivec2 region = region_of( column.position );
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+
+		RegionFile* file = find_region( region, false );
+
+		if ( file == nullptr ||
+		     !file->read( column.position - region * RegionFile::REGION_SIZE,
+		                  payload ) ||
+		     payload.empty() )
+		{
+			return false;
+		}
+	}
+
+	// format does not depend on mode, saves from either mode stay readable
+	bool sections = payload[ 0 ] == SECTIONS;
+	bool decoded  = false;
+
+	// decode without the lock, it is the expensive part
+	if ( sections )
+	{
+		decoded = decode_column( column, payload );
+	}
+	else if ( payload[ 0 ] == EDITS )
+	{
+		decoded = decode_edits( column, payload );
+	}
+
+	if ( !decoded )
+	{
+		// corrupted payload or overlay of older terrain, fall back to
+		// generation
+		for ( Chunk*& chunk : column.sections )
+		{
+			if ( chunk != nullptr )
+			{
+				chunk_pool->release( chunk );
+				chunk = nullptr;
+			}
+		}
+		column.edits.clear();
+		return false;
+	}
+
+	column.snapshot = sections;
+
+	std::lock_guard<std::mutex> lock( mutex );
+	stats.columns_loaded++;
+	stats.bytes_read += payload.size();
+
+	return sections;
+}
+
+WorldStorageStats
+WorldStorage::get_stats() const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	return stats;
+}
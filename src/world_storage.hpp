@@ -0,0 +1,98 @@
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/gtx/hash.hpp>
+#include "region_file.hpp"
+
+class ChunkManager;
+class ChunkPool;
+struct ChunkColumn;
+
+struct WorldStorageStats
+{
+	size_t columns_saved;
+	size_t columns_loaded;
+	size_t bytes_written;
+	size_t bytes_read;
+	size_t open_regions;
+};
+
+// edited columns are saved to region files when they unload and read back
+// on next load. loads run on generation workers, saves on render thread,
+// region files are shared under one lock
+class WorldStorage
+{
+public:
+	enum class Mode
+	{
+		// every voxel of edited columns, column is not generated on load
+		SNAPSHOT,
+		// only player edits, column is generated and edits replayed on load.
+		// save size follows number of edits, not explored area
+		OVERLAY
+	};
+
+private:
+	// first payload byte
+	enum Format : uint8_t
+	{
+		SECTIONS = 1,
+		EDITS    = 2
+	};
+
+	enum Encoding : uint8_t
+	{
+		RAW,
+		// ( type, length ) pairs
+		RUNS
+	};
+
+	ChunkManager* chunk_manager;
+	ChunkPool*    chunk_pool;
+	std::string   directory;
+	Mode          mode;
+
+	mutable std::mutex mutex;
+	// nullptr for regions which have no file yet
+	std::unordered_map<glm::ivec2, std::unique_ptr<RegionFile>> regions;
+	WorldStorageStats                                           stats;
+
+	RegionFile*
+	find_region( const glm::ivec2 region, bool create );
+
+	static void
+	encode_column( const ChunkColumn& column, std::vector<uint8_t>& payload );
+
+	static void
+	encode_edits( const ChunkColumn& column, std::vector<uint8_t>& payload );
+
+	bool
+	decode_column( ChunkColumn& column, const std::vector<uint8_t>& payload );
+
+	static bool
+	decode_edits( ChunkColumn& column, const std::vector<uint8_t>& payload );
+
+public:
+	void
+	init( const std::string& directory, Mode, ChunkManager*, ChunkPool* );
+
+	void
+	shutdown();
+
+	void
+	save_column( const ChunkColumn& column );
+
+	// fills sections of a column which has none yet. false when column has
+	// to be generated, saved edits are already in column edits then
+	bool
+	load_column( ChunkColumn& column );
+
+	WorldStorageStats
+	get_stats() const;
+};